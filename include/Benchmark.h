@@ -0,0 +1,34 @@
+//
+// Created by X on 16/10/24.
+//
+
+#ifndef TONIC_BENCHMARK_H
+#define TONIC_BENCHMARK_H
+
+#include <string>
+
+
+/**
+ * Micro-benchmarks of the building blocks of Tonic, run by the Benchmark executable
+ */
+class Benchmark {
+
+public:
+
+    static void rng(std::string &dataset_path, long memory_budget);
+
+    static void heap(std::string &dataset_path, long heavy_size);
+
+    static void oracle(std::string &oracle_path, std::string &oracle_type, std::string &dataset_path,
+                       long memory_budget);
+
+    static void batch(bool fully_dynamic, std::string &dataset_path, std::string &oracle_path,
+                      std::string &oracle_type, long memory_budget);
+
+    static void relabel(std::string &dataset_path, long memory_budget, std::string &oracle_path,
+                        std::string &oracle_type, std::string &scratch_path);
+
+};
+
+
+#endif
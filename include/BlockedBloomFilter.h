@@ -0,0 +1,77 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_BLOCKEDBLOOMFILTER_H
+#define TONIC_BLOCKEDBLOOMFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Split block Bloom filter: each key sets one bit in each of the 8 32-bit words of a single 256-bit block, so a
+ * membership test touches one cache line. With 12 bits per key about 0.5% of the keys not in the set pass the filter.
+ */
+class BlockedBloomFilter {
+
+private:
+
+    struct alignas(32) Block {
+        uint32_t words[8];
+    };
+
+    constexpr static uint32_t SALT[8] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                         0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+    std::vector<Block> blocks_;
+
+    inline static uint64_t mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    inline size_t block_index(uint64_t h) const {
+        return (size_t) (((h >> 32) * (uint64_t) blocks_.size()) >> 32);
+    }
+
+public:
+
+    /**
+     * Filter for n keys, with the given number of bits per key
+     */
+    BlockedBloomFilter(size_t n, double bits_per_key);
+
+    void insert(uint64_t key);
+
+    /**
+     * Return false if key is not in the set, true if it may be
+     */
+    inline bool may_contain(uint64_t key) const {
+        uint64_t h = mix(key);
+        const Block &b = blocks_[block_index(h)];
+        auto x = (uint32_t) h;
+        bool found = true;
+        for (int i = 0; i < 8; i++) {
+            found &= (b.words[i] >> ((x * SALT[i]) >> 27)) & 1u;
+        }
+        return found;
+    }
+
+    /**
+     * Prefetch the block of key, ahead of may_contain
+     */
+    inline void prefetch(uint64_t key) const {
+        __builtin_prefetch(&blocks_[block_index(mix(key))]);
+    }
+
+    inline size_t memory_bytes() const { return blocks_.size() * sizeof(Block); }
+
+};
+
+
+#endif
@@ -0,0 +1,73 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_COLOURPARTITION_H
+#define TONIC_COLOURPARTITION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Partition of the triangles of a stream by colour triples, to count them on independent shards. Nodes are hashed into
+ * c colours, and there is one shard per multiset {x <= y <= z} of 3 colours, so c (c + 1) (c + 2) / 6 shards. An edge
+ * whose endpoints have colours {a, b} is routed to the c shards whose triple contains {a, b}, so the three edges of a
+ * triangle with colours {x, y, z} all reach shard {x, y, z}. A shard counts a triangle only if the colour of its third
+ * node completes the triple (see missing_colour): every triangle is then counted by exactly one shard, and the global
+ * count is the sum of the counts of the shards, without rescaling.
+ */
+class ColourPartition {
+
+private:
+
+    int num_colours_;
+    uint64_t seed_;
+
+    std::vector<int> triples_;
+    // -- shards of each ordered colour pair (a, b), at a * c + b
+    std::vector<std::vector<int>> pair_shards_;
+    // -- colour completing the triple of a shard for each colour pair, -1 if the pair is not in the triple
+    std::vector<int8_t> missing_;
+
+public:
+
+    constexpr static int MAX_COLOURS = 64;
+
+    ColourPartition(int num_colours, uint64_t seed);
+
+    inline int colour(int u) const {
+        uint64_t h = ((uint64_t) (uint32_t) u ^ seed_) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+        return (int) (((h & 0xffffffffull) * (uint64_t) num_colours_) >> 32);
+    }
+
+    inline int num_colours() const { return num_colours_; }
+
+    inline int num_shards() const { return (int) triples_.size() / 3; }
+
+    /**
+     * Return the shards the edges with endpoint colours a and b are routed to
+     */
+    inline const std::vector<int> &shards_of(int a, int b) const {
+        return pair_shards_[a * num_colours_ + b];
+    }
+
+    /**
+     * Return the colour that the third node of a triangle closed by an edge with endpoint colours a and b must have to
+     * be counted by shard, -1 if such edges are not routed to shard
+     */
+    inline int missing_colour(int shard, int a, int b) const {
+        return missing_[((size_t) shard * num_colours_ + a) * num_colours_ + b];
+    }
+
+    /**
+     * Return the expected fraction of the edges of the stream routed to shard, with uniform colours. The fractions of
+     * all the shards sum to c, since every edge is routed to c shards
+     */
+    double edge_share(int shard) const;
+
+};
+
+
+#endif
@@ -0,0 +1,172 @@
+//
+// Created by X on 12/10/24.
+//
+
+#ifndef TONIC_EDGESTREAMREADER_H
+#define TONIC_EDGESTREAMREADER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * A single row of a preprocessed stream: (u v t) for insertion-only streams, (u v t sign) for fully dynamic ones.
+ * Rows without a sign are read as additions.
+ */
+struct StreamEdge {
+    int u;
+    int v;
+    int t;
+    int sign;
+};
+
+/**
+ * Header of the binary edge stream format. All fields and records are little-endian. Records follow the header and
+ * are fixed-width: u, v, t as int32, plus a trailing int8 sign (+1 / -1) when FLAG_SIGNED is set (fully dynamic
+ * streams).
+ */
+struct BinaryStreamHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t max_node_id;
+
+    constexpr static char MAGIC[8] = {'T', 'O', 'N', 'I', 'C', 'E', 'S', '\0'};
+    constexpr static uint32_t VERSION = 1;
+    constexpr static uint32_t FLAG_SIGNED = 1;
+
+    inline size_t record_size() const { return (flags & FLAG_SIGNED) ? 13 : 12; }
+};
+
+static_assert(sizeof(BinaryStreamHeader) == 40, "BinaryStreamHeader must be packed");
+
+/**
+ * Zero-copy reader for preprocessed edge streams. The file is memory-mapped and walked in place with a hand-rolled
+ * integer parser, so that no allocation is performed per row. Binary streams (see BinaryStreamHeader) are detected by
+ * their magic and decoded directly. Edges are returned in batches.
+ */
+class EdgeStreamReader {
+
+private:
+
+    std::string path_;
+    int fd_ = -1;
+
+    const char *data_ = nullptr;
+    const char *cur_ = nullptr;
+    const char *end_ = nullptr;
+    size_t size_ = 0;
+
+    bool binary_ = false;
+    BinaryStreamHeader header_{};
+
+    // -- text rows consumed so far, and whether the stream was stopped by an invalid row
+    size_t rows_ = 0;
+    bool failed_ = false;
+
+    static bool parse_int(const char *&p, const char *end, int &value);
+
+    size_t next_text_batch(StreamEdge *batch, size_t max_edges);
+
+    size_t next_binary_batch(StreamEdge *batch, size_t max_edges);
+
+public:
+
+    constexpr static size_t DEFAULT_BATCH_SIZE = 1 << 16;
+
+    explicit EdgeStreamReader(const std::string &path);
+
+    ~EdgeStreamReader();
+
+    EdgeStreamReader(const EdgeStreamReader &) = delete;
+
+    EdgeStreamReader &operator=(const EdgeStreamReader &) = delete;
+
+    bool open();
+
+    void close();
+
+    size_t next_batch(StreamEdge *batch, size_t max_edges);
+
+    /**
+     * Apply f to every edge of the stream, in stream order
+     * @param f callable taking a const StreamEdge&
+     * @return true if the stream was opened and read to the end, false otherwise
+     */
+    template<typename F>
+    bool for_each_edge(F &&f) {
+        if (data_ == nullptr and !open()) return false;
+        std::vector<StreamEdge> batch(DEFAULT_BATCH_SIZE);
+        size_t n;
+        while ((n = next_batch(batch.data(), batch.size())) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                f(batch[i]);
+            }
+        }
+        return !failed_;
+    }
+
+    inline size_t bytes_read() const { return (size_t) (cur_ - data_); }
+
+    inline size_t file_size() const { return size_; }
+
+    inline bool is_binary() const { return binary_; }
+
+    /**
+     * Return true if the stream was stopped early by a row that could not be parsed
+     */
+    inline bool failed() const { return failed_; }
+
+    inline const BinaryStreamHeader &header() const { return header_; }
+
+    static bool is_binary_file(const std::string &path);
+
+};
+
+/**
+ * Writer for preprocessed edge streams, either in the text format (u v t [sign]) or in the binary format described
+ * by BinaryStreamHeader.
+ */
+class EdgeStreamWriter {
+
+private:
+
+    std::string path_;
+    bool binary_;
+    bool signed_;
+    FILE *file_ = nullptr;
+
+    std::vector<char> buffer_;
+    size_t buffer_len_ = 0;
+    // -- set when a write of the placeholder header or of the buffered rows falls short, reported by close()
+    bool write_failed_ = false;
+
+    uint64_t num_edges_ = 0;
+    uint64_t max_node_id_ = 0;
+
+    void flush();
+
+public:
+
+    EdgeStreamWriter(const std::string &path, bool binary, bool signed_stream);
+
+    ~EdgeStreamWriter();
+
+    EdgeStreamWriter(const EdgeStreamWriter &) = delete;
+
+    EdgeStreamWriter &operator=(const EdgeStreamWriter &) = delete;
+
+    bool open();
+
+    void write(int u, int v, int t, int sign = 1);
+
+    bool close(uint64_t num_nodes);
+
+};
+
+
+#endif
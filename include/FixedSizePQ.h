@@ -1,9 +1,11 @@
 #ifndef FIXEDSIZEPQ_H
 #define FIXEDSIZEPQ_H
 
+#include "hash_table5.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <functional>
 
 template<typename T, typename Compare = std::less<T>>
 class FixedSizePQ {
@@ -50,4 +52,160 @@ private:
 
 };
 
+/**
+ * Fixed size priority queue on an indexed 4-ary heap. A position map from the key of each element (given by KeyOf) to
+ * its slot in the heap allows to erase or re-prioritize any element in place in O(log n), so that removed elements do
+ * not linger in the heap. As in FixedSizePQ, top() is the largest element according to Compare. KeyHash hashes the keys
+ * in the position map. With Indexed = false the position map is not kept, which saves a hash table write per element
+ * move for the users that only need push, pop, replace_top and top; contains, erase and update_key are then disabled.
+ */
+template<typename T, typename Compare, typename KeyOf, typename KeyHash = std::hash<unsigned long long>,
+         bool Indexed = true>
+class IndexedFixedSizePQ {
+
+public:
+
+    using Key = unsigned long long;
+
+    constexpr static size_t ARITY = 4;
+
+    IndexedFixedSizePQ() = default;
+    IndexedFixedSizePQ(size_t max_size) {
+        heap_.reserve(max_size);
+        if constexpr (Indexed) position_.reserve(max_size);
+    }
+
+    typedef typename std::vector<T>::iterator iterator;
+    iterator begin() { return heap_.begin(); }
+    iterator end() { return heap_.end(); }
+
+    inline bool empty() const { return heap_.empty(); }
+
+    inline size_t size() const { return heap_.size(); }
+
+    inline const T& top() const { return heap_.front(); }
+
+    inline bool contains(const Key key) const {
+        static_assert(Indexed, "contains needs the position map");
+        return position_.find(key) != position_.end();
+    }
+
+    /**
+     * Insert elem, whose key must not be in the queue
+     */
+    void push(const T& elem) {
+        heap_.push_back(elem);
+        sift_up(heap_.size() - 1);
+    }
+
+    void pop() {
+        erase_at(0);
+    }
+
+    /**
+     * Replace the top element with elem, with a single sift down
+     */
+    void replace_top(const T& elem) {
+        if constexpr (Indexed) position_.erase(key_of(heap_[0]));
+        heap_[0] = elem;
+        sift_down(0);
+    }
+
+    /**
+     * Remove the element with the given key
+     * @return true if the key was in the queue, false otherwise
+     */
+    bool erase(const Key key) {
+        static_assert(Indexed, "erase needs the position map");
+        auto it = position_.find(key);
+        if (it == position_.end()) return false;
+        erase_at(it->second);
+        return true;
+    }
+
+    /**
+     * Replace the element with the same key as elem, moving it up or down according to its new priority
+     * @return true if the key was in the queue, false otherwise
+     */
+    bool update_key(const T& elem) {
+        static_assert(Indexed, "update_key needs the position map");
+        auto it = position_.find(key_of(elem));
+        if (it == position_.end()) return false;
+        size_t i = it->second;
+        bool up = comp(heap_[i], elem);
+        heap_[i] = elem;
+        if (up) sift_up(i);
+        else sift_down(i);
+        return true;
+    }
+
+    /**
+     * Return the number of element moves performed by the sift operations so far
+     */
+    inline size_t moves() const { return moves_; }
+
+protected:
+    std::vector<T> heap_;
+    emhash5::HashMap<Key, size_t, KeyHash> position_;
+    size_t moves_ = 0;
+    Compare comp;
+    KeyOf key_of;
+
+    inline void place(size_t i, const T& elem) {
+        heap_[i] = elem;
+        if constexpr (Indexed) position_[key_of(elem)] = i;
+        moves_++;
+    }
+
+    void sift_up(size_t i) {
+        T elem = heap_[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / ARITY;
+            if (!comp(heap_[parent], elem)) break;
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, elem);
+    }
+
+    void sift_down(size_t i) {
+        T elem = heap_[i];
+        size_t n = heap_.size();
+        while (true) {
+            size_t first = i * ARITY + 1;
+            if (first >= n) break;
+            size_t last = std::min(first + ARITY, n);
+            size_t best = first;
+            for (size_t c = first + 1; c < last; c++) {
+                if (comp(heap_[best], heap_[c])) best = c;
+            }
+            if (!comp(elem, heap_[best])) break;
+            place(i, heap_[best]);
+            i = best;
+        }
+        place(i, elem);
+    }
+
+    void erase_at(size_t i) {
+        if constexpr (Indexed) position_.erase(key_of(heap_[i]));
+        size_t last = heap_.size() - 1;
+        if (i != last) {
+            bool up = comp(heap_[i], heap_[last]);
+            heap_[i] = heap_[last];
+            heap_.pop_back();
+            if (up) sift_up(i);
+            else sift_down(i);
+        } else {
+            heap_.pop_back();
+        }
+    }
+
+private:
+    void* operator new (size_t);
+    void* operator new[] (size_t);
+    void operator delete (void *);
+    void operator delete[] (void *);
+
+};
+
 #endif //FIXEDSIZEPQ_H
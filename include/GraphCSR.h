@@ -0,0 +1,164 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_GRAPHCSR_H
+#define TONIC_GRAPHCSR_H
+
+#include "NodeRelabelling.h"
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Static simple graph in compressed sparse row form, built from a preprocessed stream (self-loops, repeated edges and
+ * deletions are ignored: the graph is the set of distinct edges of the stream). Each edge is stored once, oriented from
+ * the endpoint with lower degree to the one with higher degree (ties by id), so that every out-neighborhood has at
+ * most O(sqrt(m)) nodes and every triangle is found exactly once by intersecting out-neighborhoods. Out-neighborhoods
+ * are sorted by id, and edge i is the i-th entry of targets_. Nodes are relabelled to [0, n) by increasing original
+ * id (see NodeRelabelling), so the arrays are sized by the nodes of the stream and not by its largest id; the methods
+ * below take and return the new ids. Edges with a negative node id are skipped.
+ */
+class GraphCSR {
+
+private:
+
+    // -- out-neighbors of u are targets_[offsets_[u]] .. targets_[offsets_[u + 1] - 1]
+    std::vector<uint64_t> offsets_;
+    std::vector<int> targets_;
+    // -- degree of every node in the undirected graph
+    std::vector<uint32_t> degrees_;
+    // -- original id of every node
+    NodeRelabelling relabelling_;
+    // -- edges read from the stream, self-loops and repetitions included
+    size_t stream_edges_ = 0;
+
+public:
+
+    /**
+     * Default number of distinct edges sorted in memory at a time before spilling a sorted run to disk
+     */
+    constexpr static size_t DEFAULT_CHUNK_EDGES = 1 << 26;
+
+    /**
+     * Build the degree-oriented graph of a preprocessed stream. The edges are deduplicated by sorting chunks of at most
+     * chunk_edges edges; if the stream does not fit in one chunk, the sorted chunks are spilled to files prefixed by
+     * spill_prefix and merged, so that the memory needed besides the CSR itself is bounded by the chunk size
+     * @param dataset_path
+     * @param chunk_edges
+     * @param spill_prefix
+     * @return false if the stream or the spill files could not be read or written
+     */
+    bool build(const std::string &dataset_path, size_t chunk_edges, const std::string &spill_prefix);
+
+    inline size_t num_nodes() const { return degrees_.size(); }
+
+    inline size_t num_edges() const { return targets_.size(); }
+
+    inline size_t num_stream_edges() const { return stream_edges_; }
+
+    inline uint32_t degree(int u) const { return degrees_[u]; }
+
+    inline int original_id(int u) const { return relabelling_.original_id(u); }
+
+    /**
+     * Return the id in the graph of an original node id, -1 if the node is not in the graph
+     */
+    inline int node(int original_id) const { return relabelling_.new_id(original_id); }
+
+    inline uint64_t begin(int u) const { return offsets_[u]; }
+
+    inline uint64_t end(int u) const { return offsets_[u + 1]; }
+
+    inline int target(uint64_t e) const { return targets_[e]; }
+
+    /**
+     * Return true if the edge (a, b) is oriented from a to b: a has lower degree, ties broken by id
+     */
+    inline bool precedes(int a, int b) const {
+        return degrees_[a] < degrees_[b] or (degrees_[a] == degrees_[b] and a < b);
+    }
+
+    /**
+     * Return the id of the edge (u, v), or -1 if it is not in the graph
+     */
+    inline int64_t find_edge(int u, int v) const {
+        if (u == v or u < 0 or v < 0 or (size_t) std::max(u, v) >= num_nodes()) return -1;
+        if (!precedes(u, v)) std::swap(u, v);
+        auto first = targets_.begin() + (long) offsets_[u], last = targets_.begin() + (long) offsets_[u + 1];
+        auto it = std::lower_bound(first, last, v);
+        return (it != last and *it == v) ? it - targets_.begin() : -1;
+    }
+
+    /**
+     * Visit every triangle (u, v, w) once, with u -> v, u -> w, v -> w in the orientation, calling
+     * f(u, v, w, e_uv, e_uw, e_vw) with the ids of its three edges. Only the triangles whose first node u is in
+     * [first, last) are visited, so ranges of nodes can be processed independently
+     */
+    template<typename F>
+    void for_each_triangle(int first, int last, F &&f) const {
+        for (int u = first; u < last; u++) {
+            uint64_t u_begin = offsets_[u], u_end = offsets_[u + 1];
+            for (uint64_t e_uv = u_begin; e_uv < u_end; e_uv++) {
+                int v = targets_[e_uv];
+                uint64_t i = u_begin, j = offsets_[v], v_end = offsets_[v + 1];
+                while (i < u_end and j < v_end) {
+                    if (targets_[i] < targets_[j]) {
+                        i++;
+                    } else if (targets_[j] < targets_[i]) {
+                        j++;
+                    } else {
+                        f(u, v, targets_[i], e_uv, i, j);
+                        i++;
+                        j++;
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename F>
+    void for_each_triangle(F &&f) const {
+        for_each_triangle(0, (int) num_nodes(), f);
+    }
+
+    /**
+     * Visit every triangle once as in for_each_triangle, on num_threads threads. Nodes are handed out in blocks from a
+     * shared counter, so that threads which get the nodes with large out-neighborhoods do not hold back the others.
+     * f is called concurrently and must only update shared state atomically
+     * @return the number of triangles
+     */
+    template<typename F>
+    uint64_t parallel_for_each_triangle(int num_threads, F &&f) const {
+        constexpr int BLOCK_NODES = 256;
+        int n = (int) num_nodes();
+        std::atomic<int> next_block(0);
+        std::atomic<uint64_t> triangles(0);
+        auto worker = [&]() {
+            uint64_t local_triangles = 0;
+            auto counted_f = [&](int u, int v, int w, uint64_t e_uv, uint64_t e_uw, uint64_t e_vw) {
+                f(u, v, w, e_uv, e_uw, e_vw);
+                local_triangles++;
+            };
+            for (int first = next_block.fetch_add(BLOCK_NODES); first < n; first = next_block.fetch_add(BLOCK_NODES)) {
+                for_each_triangle(first, std::min(first + BLOCK_NODES, n), counted_f);
+            }
+            triangles += local_triangles;
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < num_threads; t++) threads.emplace_back(worker);
+        worker();
+        for (auto &thread: threads) thread.join();
+        return triangles;
+    }
+
+    size_t memory_bytes() const;
+
+};
+
+
+#endif
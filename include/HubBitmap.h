@@ -0,0 +1,193 @@
+//
+// Created by X on 16/10/24.
+//
+
+#ifndef TONIC_HUBBITMAP_H
+#define TONIC_HUBBITMAP_H
+
+#include "SortedIntersect.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Roaring-style neighborhood of a hub node of the sampled subgraph. Node ids are split in chunks of 2^16 ids; each
+ * non-empty chunk has a container, either a sorted array of entries (low 16 bits of the id, with the det/light flag
+ * in the highest bit) when it holds up to ARRAY_MAX ids, or a pair of bitmaps over the chunk, one for membership and
+ * a parallel one for the det flags. Containers turn into bitmaps above ARRAY_MAX ids, and back into arrays below
+ * half of it. Two hubs are intersected container by container: bitmap pairs with word-wise AND and popcount.
+ */
+class HubBitmap {
+
+public:
+
+    constexpr static uint32_t DET_BIT = 0x80000000u;
+    constexpr static uint32_t ID_MASK = 0x7fffffffu;
+    constexpr static uint32_t CHUNK_BITS = 16;
+    constexpr static uint32_t LOW_MASK = (1u << CHUNK_BITS) - 1;
+    constexpr static uint32_t BITMAP_WORDS = (1u << CHUNK_BITS) / 64;
+    constexpr static uint32_t ARRAY_MAX = 4096;
+
+private:
+
+    struct Container {
+        // -- array container: entries sorted by id
+        std::vector<uint32_t> array;
+        // -- bitmap container: membership and det flags, BITMAP_WORDS words each
+        std::vector<uint64_t> bits;
+        std::vector<uint64_t> det;
+        uint32_t cardinality = 0;
+
+        inline bool is_bitmap() const { return !bits.empty(); }
+    };
+
+    // -- chunk keys (id >> CHUNK_BITS) in increasing order, and their containers
+    std::vector<uint32_t> keys_;
+    std::vector<Container> containers_;
+    size_t cardinality_ = 0;
+
+    /**
+     * Return the index of the container of chunk key, -1 if the chunk is empty
+     */
+    inline long find_container(uint32_t key) const {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+        if (it == keys_.end() or *it != key) return -1;
+        return it - keys_.begin();
+    }
+
+    inline static uint32_t array_lower_bound(const Container &c, uint32_t low) {
+        return (uint32_t) (std::lower_bound(c.array.begin(), c.array.end(), low, [](uint32_t x, uint32_t id) {
+            return (x & ID_MASK) < id;
+        }) - c.array.begin());
+    }
+
+    static void to_bitmap(Container &c);
+
+    static void to_array(Container &c);
+
+    /**
+     * Apply f(low, det) to the ids in a container
+     */
+    template<typename F>
+    inline static void for_each_in_container(const Container &c, F &&f) {
+        if (!c.is_bitmap()) {
+            for (uint32_t x: c.array) f(x & ID_MASK, (x & DET_BIT) != 0);
+            return;
+        }
+        for (uint32_t w = 0; w < BITMAP_WORDS; w++) {
+            uint64_t m = c.bits[w];
+            while (m) {
+                uint32_t b = (uint32_t) __builtin_ctzll(m);
+                m &= m - 1;
+                f(w * 64 + b, ((c.det[w] >> b) & 1) != 0);
+            }
+        }
+    }
+
+    /**
+     * Return -1 if low is not in the container, otherwise its det flag
+     */
+    inline static int container_status(const Container &c, uint32_t low) {
+        if (c.is_bitmap()) {
+            uint32_t w = low >> 6, b = low & 63;
+            if (!((c.bits[w] >> b) & 1)) return -1;
+            return (int) ((c.det[w] >> b) & 1);
+        }
+        uint32_t i = array_lower_bound(c, low);
+        if (i == c.array.size() or (c.array[i] & ID_MASK) != low) return -1;
+        return (c.array[i] & DET_BIT) ? 1 : 0;
+    }
+
+public:
+
+    bool insert(uint32_t id, bool det);
+
+    bool erase(uint32_t id, bool &det);
+
+    void clear();
+
+    size_t memory_bytes() const;
+
+    void count_common(const HubBitmap &other, size_t counts[3]) const;
+
+    inline size_t cardinality() const { return cardinality_; }
+
+    /**
+     * Return the status of id in the neighborhood
+     * @return -1 if id is not a neighbor, 0 if the edge is light, 1 if it is det
+     */
+    inline int status(uint32_t id) const {
+        long c = find_container(id >> CHUNK_BITS);
+        if (c < 0) return -1;
+        return container_status(containers_[c], id & LOW_MASK);
+    }
+
+    /**
+     * Apply f(id, det) to every neighbor, in increasing order of id
+     */
+    template<typename F>
+    void for_each(F &&f) const {
+        for (size_t c = 0; c < keys_.size(); c++) {
+            uint32_t high = keys_[c] << CHUNK_BITS;
+            for_each_in_container(containers_[c], [&](uint32_t low, bool det) { f(high | low, det); });
+        }
+    }
+
+    /**
+     * Apply f(id, det, other_det) to every common neighbor with other, where det and other_det are the flags on
+     * each side. Array pairs are intersected with SortedIntersect into the scratch buffers
+     */
+    template<typename F>
+    void for_each_common(const HubBitmap &other, std::vector<uint32_t> &scratch_a, std::vector<uint32_t> &scratch_b,
+                         F &&f) const {
+        size_t i = 0, j = 0;
+        while (i < keys_.size() and j < other.keys_.size()) {
+            if (keys_[i] < other.keys_[j]) {
+                i++;
+            } else if (other.keys_[j] < keys_[i]) {
+                j++;
+            } else {
+                uint32_t high = keys_[i] << CHUNK_BITS;
+                const Container &a = containers_[i++];
+                const Container &b = other.containers_[j++];
+                if (a.is_bitmap() and b.is_bitmap()) {
+                    for (uint32_t w = 0; w < BITMAP_WORDS; w++) {
+                        uint64_t m = a.bits[w] & b.bits[w];
+                        while (m) {
+                            uint32_t bit = (uint32_t) __builtin_ctzll(m);
+                            m &= m - 1;
+                            f(high | (w * 64 + bit), ((a.det[w] >> bit) & 1) != 0, ((b.det[w] >> bit) & 1) != 0);
+                        }
+                    }
+                } else if (a.is_bitmap()) {
+                    for (uint32_t x: b.array) {
+                        int s = container_status(a, x & ID_MASK);
+                        if (s >= 0) f(high | (x & ID_MASK), s == 1, (x & DET_BIT) != 0);
+                    }
+                } else if (b.is_bitmap()) {
+                    for (uint32_t x: a.array) {
+                        int s = container_status(b, x & ID_MASK);
+                        if (s >= 0) f(high | (x & ID_MASK), (x & DET_BIT) != 0, s == 1);
+                    }
+                } else {
+                    size_t n_max = std::min(a.array.size(), b.array.size());
+                    if (scratch_a.size() < n_max) {
+                        scratch_a.resize(n_max);
+                        scratch_b.resize(n_max);
+                    }
+                    size_t n = SortedIntersect::intersect(a.array.data(), a.array.size(), b.array.data(),
+                                                          b.array.size(), scratch_a.data(), scratch_b.data());
+                    for (size_t k = 0; k < n; k++) {
+                        f(high | (scratch_a[k] & ID_MASK), (scratch_a[k] & DET_BIT) != 0,
+                          (scratch_b[k] & DET_BIT) != 0);
+                    }
+                }
+            }
+        }
+    }
+
+};
+
+
+#endif
@@ -0,0 +1,54 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_LOCALCOUNTS_H
+#define TONIC_LOCALCOUNTS_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Local triangle estimates, one per node, in a dense array indexed by node id. The array grows geometrically up to the
+ * largest id updated so far, so it takes 8 bytes per id up to the largest one, with no per-entry hashing or allocation.
+ * Increments are signed, as in fully dynamic streams a deletion subtracts the triangles it destroys; nodes whose
+ * estimate is zero are not reported. Node ids are the non-negative ints; updates of negative ids are ignored.
+ */
+class LocalCounts {
+
+private:
+
+    std::vector<double> counts_;
+
+    void grow(int u);
+
+public:
+
+    inline void add(int u, double x) {
+        if (u < 0) return;
+        if ((size_t) u >= counts_.size()) grow(u);
+        counts_[u] += x;
+    }
+
+    inline double get(int u) const {
+        return u >= 0 and (size_t) u < counts_.size() ? counts_[u] : 0.0;
+    }
+
+    /**
+     * Reserve room for the node ids in [0, num_nodes), when the number of nodes is known in advance
+     */
+    inline void reserve(size_t num_nodes) {
+        if (num_nodes > counts_.size()) counts_.resize(num_nodes, 0.0);
+    }
+
+    void get_nodes(std::vector<int> &nodes) const;
+
+    void top(size_t n, std::vector<std::pair<int, double>> &top_nodes) const;
+
+    inline size_t memory_bytes() const { return counts_.capacity() * sizeof(double); }
+
+};
+
+
+#endif
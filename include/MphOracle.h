@@ -0,0 +1,132 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_MPHORACLE_H
+#define TONIC_MPHORACLE_H
+
+#include "hash_table5.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Read-only oracle table on a minimal perfect hash function. The n keys are mapped to [0, n) by a BBHash-style
+ * cascade of bit arrays (gamma = 2, about 4 bits per key with the rank directory); each slot stores a short
+ * fingerprint of its key, to reject keys not in the oracle with probability 1 - 2^-fingerprint_bits, and the
+ * heaviness quantized on 8 or 16 bits. The quantization is monotone (exact for small values, log-bucketed above), so
+ * the order between heaviness values, which is all Tonic uses, is kept up to ties within a bucket.
+ */
+class MphOracle {
+
+private:
+
+    constexpr static double GAMMA = 2.0;
+    constexpr static int MAX_LEVELS = 32;
+    // -- words of 64 bits per rank block
+    constexpr static size_t RANK_BLOCK = 8;
+
+    struct Level {
+        uint64_t size;
+        uint64_t seed;
+        // -- number of keys placed in the previous levels
+        uint64_t offset;
+        std::vector<uint64_t> bits;
+        // -- ones before each block of RANK_BLOCK words
+        std::vector<uint32_t> ranks;
+    };
+
+    std::vector<Level> levels_;
+    // -- keys not placed by the cascade, with their slot
+    emhash5::HashMap<uint64_t, uint32_t> fallback_;
+
+    int fingerprint_bits_;
+    int value_bits_;
+    std::vector<uint8_t> fingerprints_;
+    std::vector<uint8_t> values_;
+    size_t size_ = 0;
+
+    inline static uint64_t mix(uint64_t key, uint64_t seed) {
+        key ^= seed;
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    inline static uint64_t position(uint64_t key, const Level &level) {
+        return (uint64_t) (((unsigned __int128) mix(key, level.seed) * level.size) >> 64);
+    }
+
+    inline static uint32_t fingerprint(uint64_t key, int bits) {
+        return (uint32_t) (mix(key, 0x2545F4914F6CDD1Dull) >> (64 - bits));
+    }
+
+    inline static uint32_t load(const std::vector<uint8_t> &data, size_t i, int bits) {
+        return bits == 8 ? data[i] : (uint32_t) data[2 * i] | ((uint32_t) data[2 * i + 1] << 8);
+    }
+
+    static void store(std::vector<uint8_t> &data, size_t i, int bits, uint32_t x);
+
+    /**
+     * Return the slot of key in [0, size), or size if key was not placed (then it is not in the oracle)
+     */
+    inline size_t slot(uint64_t key) const {
+        for (const auto &level: levels_) {
+            uint64_t p = position(key, level);
+            uint64_t word = level.bits[p >> 6];
+            uint64_t bit = 1ull << (p & 63);
+            if (word & bit) {
+                size_t rank = level.ranks[(p >> 6) / RANK_BLOCK];
+                for (size_t w = ((p >> 6) / RANK_BLOCK) * RANK_BLOCK; w < (p >> 6); w++) {
+                    rank += __builtin_popcountll(level.bits[w]);
+                }
+                return level.offset + rank + __builtin_popcountll(word & (bit - 1));
+            }
+        }
+        if (fallback_.empty()) return size_;
+        auto it = fallback_.find(key);
+        return it != fallback_.end() ? it->second : size_;
+    }
+
+public:
+
+    /**
+     * Build the table on (key, heaviness) pairs with distinct keys
+     * @param entries
+     * @param fingerprint_bits 8 or 16
+     * @param value_bits 8 or 16
+     */
+    MphOracle(const std::vector<std::pair<uint64_t, int>> &entries, int fingerprint_bits, int value_bits);
+
+    /**
+     * Prefetch the word of the first level holding the bit of key, where most keys are placed
+     */
+    inline void prefetch(uint64_t key) const {
+        if (!levels_.empty()) __builtin_prefetch(&levels_[0].bits[position(key, levels_[0]) >> 6]);
+    }
+
+    /**
+     * Return the (dequantized) heaviness of key, or -1 if key is not in the oracle. Keys not in the oracle are
+     * reported with probability at most 2^-fingerprint_bits
+     */
+    inline int lookup(uint64_t key) const {
+        size_t i = slot(key);
+        if (i >= size_ or load(fingerprints_, i, fingerprint_bits_) != fingerprint(key, fingerprint_bits_)) return -1;
+        return dequantize(load(values_, i, value_bits_), value_bits_);
+    }
+
+    static uint32_t quantize(int heaviness, int bits);
+
+    static int dequantize(uint32_t code, int bits);
+
+    inline size_t size() const { return size_; }
+
+    size_t memory_bytes() const;
+
+};
+
+
+#endif
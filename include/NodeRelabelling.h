@@ -0,0 +1,77 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_NODERELABELLING_H
+#define TONIC_NODERELABELLING_H
+
+#include "hash_table5.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Dense relabelling of the node ids of a stream to [0, n), so that per-node state can be kept in flat arrays of n
+ * entries. The order of the new ids is given by a strategy:
+ * - ID: increasing original id, so the relative order of the nodes (and the tie-breaks by id) are kept;
+ * - DEGREE: decreasing degree in the graph of the stream (ties by original id), so the hubs share the first ids;
+ * - FIRST: first appearance in the stream, so the nodes of the edges close in time get close ids;
+ * - RCM: reverse Cuthill-McKee order, a breadth-first order from low-degree nodes, reversed, which gives close ids to
+ *   the neighbors of each node.
+ * The mapping is saved as `new_id original_id` rows, by new id.
+ */
+class NodeRelabelling {
+
+public:
+
+    enum class Strategy { ID, DEGREE, FIRST, RCM };
+
+private:
+
+    std::vector<int> original_ids_;
+    emhash5::HashMap<int, int> new_ids_;
+
+    void index_original_ids();
+
+    static std::vector<int> rcm_order(const std::vector<std::pair<int, int>> &edges, size_t num_nodes);
+
+public:
+
+    /**
+     * Relabelling of the endpoints of the given edges, in stream order
+     */
+    static NodeRelabelling build(const std::vector<std::pair<int, int>> &edges, Strategy strategy);
+
+    /**
+     * Relabelling of the given nodes by increasing original id, as Strategy::ID; repeated nodes are allowed
+     */
+    static NodeRelabelling from_nodes(std::vector<int> nodes);
+
+    static bool parse_strategy(const std::string &name, Strategy &strategy);
+
+    static const char *strategy_name(Strategy strategy);
+
+    static bool read(const std::string &path, NodeRelabelling &relabelling);
+
+    /**
+     * Return the new id of an original id, -1 if the node is not relabelled
+     */
+    inline int new_id(int u) const {
+        auto it = new_ids_.find(u);
+        return it != new_ids_.end() ? it->second : -1;
+    }
+
+    inline int original_id(int u) const { return original_ids_[u]; }
+
+    inline size_t num_nodes() const { return original_ids_.size(); }
+
+    bool write(const std::string &path) const;
+
+    void relabel_entries(bool edges, std::vector<std::pair<uint64_t, int>> &entries) const;
+
+};
+
+
+#endif
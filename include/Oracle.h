@@ -0,0 +1,254 @@
+//
+// Created by X on 17/10/24.
+//
+
+#ifndef TONIC_ORACLE_H
+#define TONIC_ORACLE_H
+
+#include "hash_table5.hpp"
+#include "BlockedBloomFilter.h"
+#include "MphOracle.h"
+#include "Utils.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Header of the binary oracle format. All fields are little-endian. The header is followed by an open-addressed table
+ * of `capacity` slots (a power of two, at most half full), stored as capacity uint64 keys and then capacity int32
+ * labels. Keys are node ids for node oracles and Utils::edge_to_id(u, v) for edge oracles; empty slots hold EMPTY_KEY.
+ * Version 1 files used the former edge key (u * 10^8 + v), which overflows for large ids, and must be rebuilt.
+ * A key is looked up by linear probing from slot hash(key) & (capacity - 1), so the file is queried in place once
+ * mapped, without parsing or rehashing.
+ */
+struct BinaryOracleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t type;
+    uint64_t num_entries;
+    uint64_t capacity;
+
+    constexpr static char MAGIC[8] = {'T', 'O', 'N', 'I', 'C', 'O', 'R', '\0'};
+    constexpr static uint32_t VERSION = 2;
+    constexpr static uint64_t EMPTY_KEY = UINT64_MAX;
+
+    inline static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        return key;
+    }
+};
+
+static_assert(sizeof(BinaryOracleHeader) == 32, "BinaryOracleHeader must be packed");
+
+/**
+ * Immutable heaviness predictor, on nodes or on edges. The tables are moved in at construction (or mapped read-only
+ * from a binary oracle file) and never modified once shared, so a single oracle can be shared through a
+ * std::shared_ptr<const Oracle> by any number of Tonic instances, also concurrently, without copies.
+ * Backends: HASH_MAP (emhash table read from a text oracle), MAPPED (binary oracle file queried in place) and MPH
+ * (minimal perfect hash with fingerprints and quantized heaviness, see MphOracle); node oracles on a dense id range
+ * [0, n) can also be turned into a DENSE array of n labels, indexed by node id. An optional blocked Bloom filter
+ * on the keys rejects most of the keys not in the oracle before the table is probed.
+ */
+class Oracle {
+
+public:
+
+    enum class Type { NODES, EDGES };
+
+    enum class Backend { HASH_MAP, MAPPED, MPH, DENSE };
+
+    /**
+     * Lookup counters of a single Tonic instance: misses are lookups - hits, filtered of them rejected by the filter
+     */
+    struct Stats {
+        size_t lookups = 0;
+        size_t hits = 0;
+        size_t filtered = 0;
+    };
+
+private:
+
+    Type type_;
+    Backend backend_;
+    emhash5::HashMap<int, int> node_oracle_;
+    emhash5::HashMap<long, int, Utils::hash_edge_id> edge_id_oracle_;
+
+    // -- mapped binary oracle, if any
+    void *mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const uint64_t *keys_ = nullptr;
+    const int32_t *labels_ = nullptr;
+    uint64_t mask_ = 0;
+    size_t num_entries_ = 0;
+
+    // -- MPH table, if any
+    std::unique_ptr<MphOracle> mph_;
+
+    // -- label of every node id of a DENSE node oracle, -1 for the nodes not in the oracle
+    std::vector<int32_t> dense_labels_;
+
+    std::unique_ptr<BlockedBloomFilter> filter_;
+    double filter_bits_per_key_ = 0.0;
+
+    void build_filter(const std::vector<std::pair<uint64_t, int>> &entries, double bits_per_key);
+
+    inline bool filtered_out(uint64_t key) const {
+        return filter_ != nullptr and !filter_->may_contain(key);
+    }
+
+    Oracle(Type type, void *mapping, size_t mapping_size);
+
+    Oracle(Type type, std::unique_ptr<MphOracle> mph);
+
+    Oracle(std::vector<int32_t> &&dense_labels, size_t num_entries);
+
+    inline int mapped_label(uint64_t key) const {
+        for (uint64_t i = BinaryOracleHeader::hash(key) & mask_;; i = (i + 1) & mask_) {
+            if (keys_[i] == key) return labels_[i];
+            if (keys_[i] == BinaryOracleHeader::EMPTY_KEY) return -1;
+        }
+    }
+
+    /**
+     * Prefetch the cache line first read by the lookup of key: its filter block if there is a filter (most keys not in
+     * the oracle stop there), otherwise its home slot. The emhash tables of text oracles are not prefetched
+     */
+    inline void prefetch_key(uint64_t key) const {
+        if (filter_ != nullptr) {
+            filter_->prefetch(key);
+            return;
+        }
+        if (backend_ == Backend::MAPPED) {
+            uint64_t i = BinaryOracleHeader::hash(key) & mask_;
+            __builtin_prefetch(&keys_[i]);
+            __builtin_prefetch(&labels_[i]);
+        } else if (backend_ == Backend::MPH) {
+            mph_->prefetch(key);
+        } else if (backend_ == Backend::DENSE and key < dense_labels_.size()) {
+            __builtin_prefetch(&dense_labels_[key]);
+        }
+    }
+
+    /**
+     * Return the label of a node id or edge id, -1 if it is not in the oracle
+     */
+    inline int label(uint64_t key) const {
+        switch (backend_) {
+            case Backend::MAPPED:
+                return mapped_label(key);
+            case Backend::MPH:
+                return mph_->lookup(key);
+            case Backend::DENSE:
+                return key < dense_labels_.size() ? dense_labels_[key] : -1;
+            default:
+                if (type_ == Type::EDGES) {
+                    auto id_it = edge_id_oracle_.find((long) key);
+                    return id_it != edge_id_oracle_.end() ? id_it->second : -1;
+                } else {
+                    auto it = node_oracle_.find((int) key);
+                    return it != node_oracle_.end() ? it->second : -1;
+                }
+        }
+    }
+
+public:
+
+    explicit Oracle(emhash5::HashMap<int, int> &&node_oracle);
+
+    explicit Oracle(emhash5::HashMap<long, int, Utils::hash_edge_id> &&edge_id_oracle);
+
+    ~Oracle();
+
+    Oracle(const Oracle &) = delete;
+
+    Oracle &operator=(const Oracle &) = delete;
+
+    static std::shared_ptr<Oracle> read_node_oracle(std::string &oracle_filename, char delimiter, int skip);
+
+    static std::shared_ptr<Oracle> read_edge_oracle(std::string &oracle_filename, char delimiter, int skip);
+
+    static std::shared_ptr<Oracle> map_binary_oracle(const std::string &oracle_filename);
+
+    static bool is_binary_file(const std::string &path);
+
+    static bool write_binary_oracle(const std::string &path, Type type,
+                                    const std::vector<std::pair<uint64_t, int>> &entries);
+
+    static std::shared_ptr<Oracle> build_mph_oracle(const Oracle &source, int fingerprint_bits, int value_bits);
+
+    static std::shared_ptr<Oracle> build_dense_node_oracle(const Oracle &source, size_t num_nodes);
+
+    void get_entries(std::vector<std::pair<uint64_t, int>> &entries) const;
+
+    bool build_filter(double bits_per_key);
+
+    /**
+     * Return the predicted heaviness of the edge (u, v): the label of the edge for an edge oracle, the minimum label of
+     * its endpoints for a node oracle, or -1 if the edge (or one of its endpoints) is not in the oracle
+     * @param u
+     * @param v
+     * @param stats updated with the outcome of the lookup
+     */
+    inline int get_heaviness(const int u, const int v, Stats &stats) const {
+        stats.lookups++;
+        int heaviness;
+        if (type_ == Type::EDGES) {
+            uint64_t key = Utils::edge_to_id(u, v);
+            if (filtered_out(key)) {
+                stats.filtered++;
+                return -1;
+            }
+            heaviness = label(key);
+        } else {
+            // -- node oracles hold no negative ids, and (uint64_t) -1 would be read as the empty key
+            if (u < 0 or v < 0) return -1;
+            if (filtered_out((uint64_t) u) or filtered_out((uint64_t) v)) {
+                stats.filtered++;
+                return -1;
+            }
+            int hu = label((uint64_t) u);
+            int hv = hu < 0 ? -1 : label((uint64_t) v);
+            heaviness = hv < 0 ? -1 : std::min(hu, hv);
+        }
+        stats.hits += heaviness >= 0;
+        return heaviness;
+    }
+
+    inline int get_heaviness(const int u, const int v) const {
+        Stats stats;
+        return get_heaviness(u, v, stats);
+    }
+
+    /**
+     * Prefetch the memory read by get_heaviness(u, v), so that the lookup of an upcoming edge does not stall
+     */
+    inline void prefetch(const int u, const int v) const {
+        if (type_ == Type::EDGES) {
+            prefetch_key(Utils::edge_to_id(u, v));
+        } else if (u >= 0 and v >= 0) {
+            prefetch_key((uint64_t) u);
+            prefetch_key((uint64_t) v);
+        }
+    }
+
+    inline Type type() const { return type_; }
+
+    inline bool is_edge_oracle() const { return type_ == Type::EDGES; }
+
+    inline Backend backend() const { return backend_; }
+
+    size_t size() const;
+
+    size_t memory_bytes() const;
+
+    inline bool has_filter() const { return filter_ != nullptr; }
+
+    inline size_t filter_memory_bytes() const { return filter_ ? filter_->memory_bytes() : 0; }
+
+};
+
+
+#endif
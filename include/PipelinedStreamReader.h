@@ -0,0 +1,89 @@
+//
+// Created by X on 14/10/24.
+//
+
+#ifndef TONIC_PIPELINEDSTREAMREADER_H
+#define TONIC_PIPELINEDSTREAMREADER_H
+
+#include "EdgeStreamReader.h"
+#include "SPSCRing.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Pipelined ingestion of a preprocessed stream: a background producer thread parses batches of edges with an
+ * EdgeStreamReader into a SPSCRing, while the calling (sampler) thread consumes them. Parsing and I/O thus overlap
+ * with the processing of the edges. Each side accounts for the time it spends waiting on the other one.
+ */
+class PipelinedStreamReader {
+
+private:
+
+    struct Batch {
+        std::vector<StreamEdge> edges;
+        size_t size = 0;
+        // -- set on the last batch published by the producer
+        bool last = false;
+    };
+
+    std::string path_;
+    size_t batch_size_;
+
+    std::unique_ptr<EdgeStreamReader> reader_;
+    SPSCRing<Batch> ring_;
+    std::thread producer_;
+    bool holding_batch_ = false;
+    bool finished_ = false;
+
+    // -- statistics, each written by a single side
+    double parse_time_ = 0.0;
+    double producer_stall_time_ = 0.0;
+    double consumer_stall_time_ = 0.0;
+    size_t bytes_read_ = 0;
+
+    void produce();
+
+public:
+
+    constexpr static size_t DEFAULT_RING_CAPACITY = 8;
+
+    PipelinedStreamReader(const std::string &path, size_t batch_size, size_t ring_capacity);
+
+    ~PipelinedStreamReader();
+
+    PipelinedStreamReader(const PipelinedStreamReader &) = delete;
+
+    PipelinedStreamReader &operator=(const PipelinedStreamReader &) = delete;
+
+    bool start();
+
+    const StreamEdge *next_batch(size_t &n);
+
+    void join();
+
+    /**
+     * Seconds spent by the producer parsing (valid after join)
+     */
+    inline double parse_time() const { return parse_time_; }
+
+    /**
+     * Seconds the producer waited because the ring was full (valid after join)
+     */
+    inline double producer_stall_time() const { return producer_stall_time_; }
+
+    /**
+     * Seconds the consumer waited because the ring was empty
+     */
+    inline double consumer_stall_time() const { return consumer_stall_time_; }
+
+    /**
+     * Bytes parsed by the producer (valid after join)
+     */
+    inline size_t bytes_read() const { return bytes_read_; }
+
+};
+
+
+#endif
@@ -0,0 +1,267 @@
+//
+// Created by X on 16/10/24.
+//
+
+#ifndef TONIC_RANDOM_H
+#define TONIC_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Splitmix64 step, used to expand a seed into the state of the generators
+ */
+inline uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Map 64 random bits to a uniform double in [0, 1)
+ */
+inline double bits_to_double(uint64_t x) {
+    return (double) (x >> 11) * 0x1.0p-53;
+}
+
+/**
+ * xoshiro256** by Blackman and Vigna: 256-bit state, 64-bit outputs
+ */
+class Xoshiro256ss {
+
+private:
+
+    uint64_t s_[4];
+
+    inline static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+
+    constexpr static const char *NAME = "xoshiro256**";
+
+    explicit Xoshiro256ss(uint64_t seed) {
+        for (auto &s: s_) s = splitmix64(seed);
+    }
+
+    inline uint64_t next() {
+        uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    inline void fill_uniforms(double *out, size_t n) {
+        for (size_t i = 0; i < n; i++) out[i] = bits_to_double(next());
+    }
+
+};
+
+/**
+ * PCG64 (XSL-RR output on a 128-bit LCG) by O'Neill
+ */
+class Pcg64 {
+
+private:
+
+    unsigned __int128 state_;
+    unsigned __int128 increment_;
+
+    constexpr static unsigned __int128 MULTIPLIER =
+            ((unsigned __int128) 0x2360ED051FC65DA4ull << 64) | 0x4385DF649FCCF645ull;
+
+public:
+
+    constexpr static const char *NAME = "pcg64";
+
+    explicit Pcg64(uint64_t seed) {
+        uint64_t s0 = splitmix64(seed), s1 = splitmix64(seed), i0 = splitmix64(seed), i1 = splitmix64(seed);
+        increment_ = (((unsigned __int128) i0 << 64) | i1) | 1;
+        state_ = 0;
+        next();
+        state_ += ((unsigned __int128) s0 << 64) | s1;
+        next();
+    }
+
+    inline uint64_t next() {
+        state_ = state_ * MULTIPLIER + increment_;
+        uint64_t x = (uint64_t) (state_ >> 64) ^ (uint64_t) state_;
+        unsigned rot = (unsigned) (state_ >> 122);
+        return (x >> rot) | (x << ((64 - rot) & 63));
+    }
+
+    inline void fill_uniforms(double *out, size_t n) {
+        for (size_t i = 0; i < n; i++) out[i] = bits_to_double(next());
+    }
+
+};
+
+/**
+ * Philox4x32-10 by Salmon et al.: counter-based, each block of 4x32 bits is a keyed bijection of a counter, so bulk
+ * generation has no serial dependency between blocks
+ */
+class Philox4x32 {
+
+private:
+
+    uint32_t key_[2];
+    uint64_t counter_ = 0;
+    uint64_t spare_ = 0;
+    bool has_spare_ = false;
+
+    constexpr static uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    constexpr static uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+    /**
+     * Encrypt the counter c, writing 128 random bits to out[0..1]
+     */
+    inline void block(uint64_t c, uint64_t *out) const {
+        uint32_t x0 = (uint32_t) c, x1 = (uint32_t) (c >> 32), x2 = 0, x3 = 0;
+        uint32_t k0 = key_[0], k1 = key_[1];
+        for (int r = 0; r < 10; r++) {
+            uint64_t p0 = (uint64_t) M0 * x0;
+            uint64_t p1 = (uint64_t) M1 * x2;
+            uint32_t y0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+            uint32_t y1 = (uint32_t) p1;
+            uint32_t y2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+            uint32_t y3 = (uint32_t) p0;
+            x0 = y0;
+            x1 = y1;
+            x2 = y2;
+            x3 = y3;
+            k0 += W0;
+            k1 += W1;
+        }
+        out[0] = ((uint64_t) x0 << 32) | x1;
+        out[1] = ((uint64_t) x2 << 32) | x3;
+    }
+
+public:
+
+    constexpr static const char *NAME = "philox4x32";
+
+    explicit Philox4x32(uint64_t seed) {
+        uint64_t k = splitmix64(seed);
+        key_[0] = (uint32_t) k;
+        key_[1] = (uint32_t) (k >> 32);
+    }
+
+    inline uint64_t next() {
+        if (has_spare_) {
+            has_spare_ = false;
+            return spare_;
+        }
+        uint64_t out[2];
+        block(counter_++, out);
+        spare_ = out[1];
+        has_spare_ = true;
+        return out[0];
+    }
+
+    inline void fill_uniforms(double *out, size_t n) {
+        size_t i = 0;
+        if (has_spare_ and n > 0) {
+            out[i++] = bits_to_double(spare_);
+            has_spare_ = false;
+        }
+        uint64_t bits[2];
+        for (; i + 2 <= n; i += 2) {
+            block(counter_++, bits);
+            out[i] = bits_to_double(bits[0]);
+            out[i + 1] = bits_to_double(bits[1]);
+        }
+        if (i < n) out[i] = bits_to_double(next());
+    }
+
+};
+
+/**
+ * Per-instance source of random numbers on top of one of the engines above. Uniform doubles are generated in bulk
+ * into a buffer and served from it; bounded integers are drawn with Lemire's multiply-shift method, without bias.
+ */
+template<typename Engine>
+class RandomSource {
+
+public:
+
+    constexpr static size_t BUFFER_SIZE = 256;
+
+private:
+
+    Engine engine_;
+    double uniforms_[BUFFER_SIZE];
+    size_t pos_ = BUFFER_SIZE;
+    size_t generated_ = 0;
+
+    void refill() {
+        engine_.fill_uniforms(uniforms_, BUFFER_SIZE);
+        pos_ = 0;
+    }
+
+public:
+
+    explicit RandomSource(uint64_t seed) : engine_(seed) {}
+
+    inline static const char *name() { return Engine::NAME; }
+
+    /**
+     * Return a uniform double in [0, 1)
+     */
+    inline double next_double() {
+        if (pos_ == BUFFER_SIZE) refill();
+        generated_++;
+        return uniforms_[pos_++];
+    }
+
+    /**
+     * Return a uniform integer in [0, n), n > 0
+     */
+    inline uint64_t next_index(uint64_t n) {
+        generated_++;
+        unsigned __int128 m = (unsigned __int128) engine_.next() * n;
+        uint64_t low = (uint64_t) m;
+        if (low < n) {
+            uint64_t threshold = -n % n;
+            while (low < threshold) {
+                generated_++;
+                m = (unsigned __int128) engine_.next() * n;
+                low = (uint64_t) m;
+            }
+        }
+        return (uint64_t) (m >> 64);
+    }
+
+    /**
+     * Write n uniform doubles in [0, 1) to out
+     */
+    void fill_uniforms(double *out, size_t n) {
+        engine_.fill_uniforms(out, n);
+        generated_ += n;
+    }
+
+    /**
+     * Return the number of random outputs consumed so far: uniforms served by next_double and fill_uniforms, and engine
+     * outputs drawn by next_index, rejected ones included. Uniforms buffered but not yet served are not counted
+     */
+    inline size_t generated() const { return generated_; }
+
+};
+
+// -- engine selected at compile time with -DTONIC_RNG=xoshiro|pcg64|philox
+#if defined(TONIC_RNG_PCG64)
+using TonicRandom = RandomSource<Pcg64>;
+#elif defined(TONIC_RNG_PHILOX)
+using TonicRandom = RandomSource<Philox4x32>;
+#else
+using TonicRandom = RandomSource<Xoshiro256ss>;
+#endif
+
+
+#endif
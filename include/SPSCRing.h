@@ -0,0 +1,94 @@
+//
+// Created by X on 14/10/24.
+//
+
+#ifndef TONIC_SPSCRING_H
+#define TONIC_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Lock-free single-producer/single-consumer ring of preallocated slots. The producer fills the slot returned by
+ * producer_slot() in place and publishes it with push(); the consumer reads the slot returned by consumer_slot() and
+ * releases it with pop(). Each side caches the index of the other one, so the shared atomics are touched only when
+ * the cached view says the ring is full (producer) or empty (consumer).
+ */
+template<typename T>
+class SPSCRing {
+
+private:
+
+    std::vector<T> slots_;
+    size_t mask_;
+
+    // -- written by the consumer, read by the producer
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // -- written by the producer, read by the consumer
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+
+public:
+
+    /**
+     * @param capacity number of slots, rounded up to a power of two
+     */
+    explicit SPSCRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    inline size_t capacity() const { return slots_.size(); }
+
+    /**
+     * Access all slots, e.g. to preallocate them before starting the producer
+     */
+    inline std::vector<T> &slots() { return slots_; }
+
+    /**
+     * Producer side: return the next free slot, or nullptr if the ring is full
+     */
+    inline T *producer_slot() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    /**
+     * Producer side: publish the slot returned by producer_slot()
+     */
+    inline void push() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Consumer side: return the oldest published slot, or nullptr if the ring is empty
+     */
+    inline T *consumer_slot() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    /**
+     * Consumer side: release the slot returned by consumer_slot()
+     */
+    inline void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+};
+
+
+#endif
@@ -0,0 +1,319 @@
+//
+// Created by X on 15/10/24.
+//
+
+#ifndef TONIC_SAMPLEDGRAPH_H
+#define TONIC_SAMPLEDGRAPH_H
+
+#include "HubBitmap.h"
+#include "SortedIntersect.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Compact adjacency store for the sampled subgraph of Tonic. Nodes live in an open-addressed directory, and the
+ * neighbors of each node are stored in a power-of-two block of a single pooled slab of 32-bit entries, with the
+ * det/light flag packed in the highest bit of the neighbor id. Node ids must be in [0, 2^31 - 1) (see valid_id): the
+ * directory marks empty slots with EMPTY_NODE = -1, and the neighbor 2^31 - 1 with the det flag set would read as
+ * EMPTY_SLOT. Edges with an endpoint outside this range are not added, and such nodes are never found.
+ * Neighborhoods of up to SMALL_CAPACITY nodes are plain arrays scanned linearly; larger ones are open-addressed
+ * tables with linear probing and backward-shift deletion. Nodes reaching SORTED_MIN_DEGREE neighbors switch to an
+ * array sorted by id, so that the common neighbors of two such nodes are found with a SIMD intersection, and hub
+ * nodes reaching the hub degree (DEFAULT_HUB_DEGREE unless set) move out of the slab into a HubBitmap. Nodes go back
+ * to the previous layout when their degree falls below half of the threshold. Freed blocks are recycled through
+ * per-size free lists.
+ */
+class SampledGraph {
+
+public:
+
+    constexpr static uint32_t DET_BIT = 0x80000000u;
+    constexpr static uint32_t ID_MASK = 0x7fffffffu;
+    constexpr static uint32_t EMPTY_SLOT = 0xffffffffu;
+    constexpr static uint32_t SMALL_CAPACITY = 8;
+    constexpr static uint32_t SORTED_MIN_DEGREE = 64;
+    constexpr static uint32_t DEFAULT_HUB_DEGREE = 4096;
+
+private:
+
+    // -- layout of the neighbor block of a node
+    enum BlockKind : uint32_t {
+        SMALL = 0, HASHED = 1, SORTED = 2, BITMAP = 3
+    };
+
+    // -- offset is the index of the hub in hubs_ for BITMAP blocks
+    struct NodeEntry {
+        int node;
+        uint32_t degree;
+        uint64_t offset: 54;
+        uint64_t cap_log: 8;
+        uint64_t kind: 2;
+    };
+
+    constexpr static int EMPTY_NODE = -1;
+
+    // -- node directory
+    std::vector<NodeEntry> table_;
+    uint32_t table_log_ = 0;
+    size_t num_nodes_ = 0;
+    size_t num_edges_ = 0;
+
+    // -- neighbor slab and free blocks, by capacity log
+    std::vector<uint32_t> slab_;
+    std::vector<uint64_t> free_blocks_[32];
+
+    // -- neighborhoods of the hub nodes, and indices of the unused ones
+    std::vector<HubBitmap> hubs_;
+    std::vector<uint64_t> free_hubs_;
+    uint32_t hub_degree_ = DEFAULT_HUB_DEGREE;
+
+    // -- output buffers of the sorted intersection
+    mutable std::vector<uint32_t> common_u_, common_v_;
+
+    inline static uint64_t node_hash(int u) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(u)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    inline static uint32_t neighbor_home(uint32_t w, uint32_t cap_log) {
+        return (w * 0x9E3779B1u) >> (32 - cap_log);
+    }
+
+    inline static bool is_hashed(const NodeEntry &e) {
+        return e.kind == HASHED;
+    }
+
+    /**
+     * Return the number of slots to scan to visit all the neighbors of e
+     */
+    inline static uint32_t block_slots(const NodeEntry &e) {
+        return is_hashed(e) ? (1u << e.cap_log) : e.degree;
+    }
+
+    uint32_t kind_for(uint32_t degree, uint32_t kind) const;
+
+    static uint32_t capacity_log_for(uint32_t degree, uint32_t kind);
+
+    void grow_table();
+
+    NodeEntry *insert_node(int u);
+
+    void erase_node(NodeEntry *e);
+
+    uint64_t allocate_block(uint32_t cap_log);
+
+    void free_block(uint64_t offset, uint32_t cap_log);
+
+    uint64_t allocate_hub();
+
+    void free_hub(uint64_t hub);
+
+    void rebuild_block(NodeEntry &e, uint32_t new_kind, uint32_t new_cap_log);
+
+    bool insert_neighbor(NodeEntry &e, uint32_t entry);
+
+    bool erase_neighbor(NodeEntry &e, uint32_t w, bool &det);
+
+    inline NodeEntry *find_node(int u) {
+        return const_cast<NodeEntry *>(static_cast<const SampledGraph *>(this)->find_node(u));
+    }
+
+    inline const NodeEntry *find_node(int u) const {
+        if (num_nodes_ == 0 or !valid_id(u)) return nullptr;
+        size_t mask = table_.size() - 1;
+        size_t i = node_hash(u) >> (64 - table_log_);
+        while (true) {
+            const NodeEntry &e = table_[i];
+            if (e.node == u) return &e;
+            if (e.node == EMPTY_NODE) return nullptr;
+            i = (i + 1) & mask;
+        }
+    }
+
+    inline uint32_t *neighbors(const NodeEntry &e) {
+        return slab_.data() + e.offset;
+    }
+
+    inline const uint32_t *neighbors(const NodeEntry &e) const {
+        return slab_.data() + e.offset;
+    }
+
+    /**
+     * Return the position of the first neighbor with id not smaller than w in a sorted block
+     */
+    inline static uint32_t sorted_lower_bound(const uint32_t *nb, uint32_t degree, uint32_t w) {
+        return (uint32_t) (std::lower_bound(nb, nb + degree, w, [](uint32_t x, uint32_t id) {
+            return (x & ID_MASK) < id;
+        }) - nb);
+    }
+
+    /**
+     * Return the slot of neighbor w in the block of e, -1 if w is not a neighbor. Not for BITMAP blocks
+     */
+    inline long find_neighbor(const NodeEntry &e, uint32_t w) const {
+        const uint32_t *nb = neighbors(e);
+        if (e.kind == SMALL) {
+            for (uint32_t i = 0; i < e.degree; i++) {
+                if ((nb[i] & ID_MASK) == w) return i;
+            }
+            return -1;
+        }
+        if (e.kind == SORTED) {
+            uint32_t i = sorted_lower_bound(nb, e.degree, w);
+            return (i < e.degree and (nb[i] & ID_MASK) == w) ? (long) i : -1;
+        }
+        uint32_t mask = (1u << e.cap_log) - 1;
+        uint32_t i = neighbor_home(w, e.cap_log);
+        while (true) {
+            uint32_t x = nb[i];
+            if (x == EMPTY_SLOT) return -1;
+            if ((x & ID_MASK) == w) return i;
+            i = (i + 1) & mask;
+        }
+    }
+
+    /**
+     * Return -1 if w is not a neighbor of e, otherwise the det flag of the edge
+     */
+    inline int neighbor_status(const NodeEntry &e, uint32_t w) const {
+        if (e.kind == BITMAP) return hubs_[e.offset].status(w);
+        long slot = find_neighbor(e, w);
+        if (slot < 0) return -1;
+        return (neighbors(e)[slot] & DET_BIT) ? 1 : 0;
+    }
+
+    /**
+     * Apply f(entry) to every neighbor entry (id with the det flag) of e
+     */
+    template<typename F>
+    inline void for_each_neighbor(const NodeEntry &e, F &&f) const {
+        if (e.kind == BITMAP) {
+            hubs_[e.offset].for_each([&](uint32_t id, bool det) { f(id | (det ? DET_BIT : 0)); });
+            return;
+        }
+        const uint32_t *nb = neighbors(e);
+        uint32_t n_slots = block_slots(e);
+        for (uint32_t i = 0; i < n_slots; i++) {
+            if (nb[i] != EMPTY_SLOT) f(nb[i]);
+        }
+    }
+
+public:
+
+    explicit SampledGraph(size_t expected_nodes = 0);
+
+    /**
+     * Return true if u can be a node of the subgraph, i.e. it is in [0, 2^31 - 1)
+     */
+    inline static bool valid_id(int u) { return (uint32_t) u < ID_MASK; }
+
+    void set_hub_degree(uint32_t hub_degree);
+
+    bool add_edge(int u, int v, bool det);
+
+    bool remove_edge(int u, int v);
+
+    bool remove_edge(int u, int v, bool &det);
+
+    /**
+     * Return the status of edge (u, v) in the subgraph
+     * @return -1 if the edge is not in the subgraph, 0 if it is light, 1 if it is det
+     */
+    inline int edge_status(int u, int v) const {
+        const NodeEntry *e = find_node(u);
+        if (e == nullptr) return -1;
+        return neighbor_status(*e, (uint32_t) v);
+    }
+
+    /**
+     * Prefetch the directory slot where the lookup of u starts
+     */
+    inline void prefetch_node(int u) const {
+        if (num_nodes_ == 0) return;
+        __builtin_prefetch(&table_[node_hash(u) >> (64 - table_log_)]);
+    }
+
+    /**
+     * Prefetch the first neighbors of u, once its directory slot is in cache (see prefetch_node)
+     */
+    inline void prefetch_neighbors(int u) const {
+        const NodeEntry *e = find_node(u);
+        if (e != nullptr and e->kind != BITMAP) __builtin_prefetch(neighbors(*e));
+    }
+
+    inline uint32_t degree(int u) const {
+        const NodeEntry *e = find_node(u);
+        return e == nullptr ? 0 : e->degree;
+    }
+
+    inline size_t num_nodes() const { return num_nodes_; }
+
+    inline size_t num_edges() const { return num_edges_; }
+
+    inline size_t num_hubs() const { return hubs_.size() - free_hubs_.size(); }
+
+    void get_nodes(std::vector<int> &nodes) const;
+
+    size_t memory_bytes() const;
+
+    void clear();
+
+    void count_common_neighbors(int u, int v, size_t counts[3]) const;
+
+    /**
+     * Apply f(w, uw_det, vw_det) to every common neighbor w of u and v, where uw_det and vw_det are the det flags of
+     * edges (u, w) and (v, w). Two hubs are intersected container by container, two sorted neighborhoods with
+     * SortedIntersect; otherwise iterates over the smaller neighborhood and probes the larger one.
+     * @param u
+     * @param v
+     * @param f
+     */
+    template<typename F>
+    void for_each_common_neighbor(int u, int v, F &&f) const {
+        const NodeEntry *eu = find_node(u);
+        if (eu == nullptr) return;
+        const NodeEntry *ev = find_node(v);
+        if (ev == nullptr) return;
+
+        if (eu->kind == BITMAP and ev->kind == BITMAP) {
+            hubs_[eu->offset].for_each_common(hubs_[ev->offset], common_u_, common_v_,
+                                              [&](uint32_t w, bool uw_det, bool vw_det) { f((int) w, uw_det, vw_det); });
+            return;
+        }
+
+        if (eu->kind == SORTED and ev->kind == SORTED) {
+            size_t n_max = std::min(eu->degree, ev->degree);
+            if (common_u_.size() < n_max) {
+                common_u_.resize(n_max);
+                common_v_.resize(n_max);
+            }
+            size_t n = SortedIntersect::intersect(neighbors(*eu), eu->degree, neighbors(*ev), ev->degree,
+                                                  common_u_.data(), common_v_.data());
+            for (size_t i = 0; i < n; i++) {
+                f((int) (common_u_[i] & ID_MASK), (common_u_[i] & DET_BIT) != 0, (common_v_[i] & DET_BIT) != 0);
+            }
+            return;
+        }
+
+        bool swapped = eu->degree > ev->degree;
+        const NodeEntry *small = swapped ? ev : eu;
+        const NodeEntry *large = swapped ? eu : ev;
+
+        for_each_neighbor(*small, [&](uint32_t x) {
+            int status = neighbor_status(*large, x & ID_MASK);
+            if (status < 0) return;
+            bool small_det = (x & DET_BIT) != 0;
+            bool large_det = status == 1;
+            if (swapped) {
+                f((int) (x & ID_MASK), large_det, small_det);
+            } else {
+                f((int) (x & ID_MASK), small_det, large_det);
+            }
+        });
+    }
+
+};
+
+
+#endif
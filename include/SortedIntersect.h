@@ -0,0 +1,61 @@
+//
+// Created by X on 16/10/24.
+//
+
+#ifndef TONIC_SORTEDINTERSECT_H
+#define TONIC_SORTEDINTERSECT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Intersection of two neighborhoods stored as arrays of 32-bit entries sorted by node id, where the highest bit of
+ * each entry is a flag ignored by the comparison. For each common id, the entries of both arrays are written out, so
+ * the caller gets the flags of both sides. The kernel (AVX2, SSE4.1 or scalar merge) is selected at runtime from the
+ * features of the CPU; very unbalanced pairs are intersected by galloping over the larger array instead.
+ */
+class SortedIntersect {
+
+public:
+
+    constexpr static uint32_t ID_MASK = 0x7fffffffu;
+
+    // -- gallop over the larger array when it is this many times larger than the smaller one
+    constexpr static size_t GALLOP_RATIO = 32;
+
+    using Kernel = size_t (*)(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                              uint32_t *out_b);
+
+    static size_t intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                            uint32_t *out_b);
+
+    static const char *kernel_name();
+
+    static size_t intersect_scalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                                   uint32_t *out_b);
+
+    static size_t intersect_gallop(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                                   uint32_t *out_b);
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    static size_t intersect_sse4(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                                 uint32_t *out_b);
+
+    static size_t intersect_avx2(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                                 uint32_t *out_b);
+
+#endif
+
+private:
+
+    static Kernel kernel_;
+
+    static const char *kernel_name_;
+
+    static Kernel select_kernel();
+
+};
+
+
+#endif
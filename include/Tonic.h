@@ -6,10 +6,19 @@
 #define TONIC_TONIC_H
 
 #include "hash_table5.hpp"
+#include "ColourPartition.h"
 #include "FixedSizePQ.h"
+#include "LocalCounts.h"
+#include "Oracle.h"
+#include "Random.h"
+#include "SampledGraph.h"
+#include "Utils.h"
 #include <iostream>
+#include <memory>
+#include <span>
 #include <string>
 #include <random>
+#include <cmath>
 
 using Edge = std::pair<int, int>;
 using Heavy_edge = std::pair<Edge, int>;
@@ -19,7 +28,7 @@ class Tonic {
 
 private:
 
-    emhash5::HashMap<int , emhash5::HashMap<int, bool>> subgraph_;
+    SampledGraph subgraph_;
 
     // -- heavy edge comparator -> return lightest edge
     struct heavy_edge_cmp {
@@ -28,18 +37,27 @@ private:
         }
     };
 
-    // -- oracles
-    emhash5::HashMap<int, int> node_oracle_;
-    emhash5::HashMap<long, int> edge_id_oracle_;
+    // -- heavy edge key -> edge id, to locate edges in the heap
+    struct heavy_edge_key {
+        unsigned long long operator()(const Heavy_edge &e) const {
+            return edge_to_id(e.first.first, e.first.second);
+        }
+    };
+
+    // -- oracle, shared with the other instances
+    std::shared_ptr<const Oracle> oracle_;
+    Oracle::Stats oracle_stats_;
 
-    // -- sets for storing edges
+    // -- colour partition of a sharded run, shared with the other shards, and the shard of this instance
+    std::shared_ptr<const ColourPartition> colours_;
+    int shard_ = -1;
+
+    // -- sets for storing edges; heavy edges only leave their heap from the top, so it keeps no position map
     Edge* waiting_room_;
-    FixedSizePQ<Heavy_edge, heavy_edge_cmp> heavy_edges_;
+    IndexedFixedSizePQ<Heavy_edge, heavy_edge_cmp, heavy_edge_key, Utils::hash_edge_id, false> heavy_edges_;
     Edge* light_edges_sample_;
 
-    std::mt19937 gen_;
-    std::uniform_real_distribution<double> dis_;
-    std::uniform_int_distribution<int> dis_int_;
+    TonicRandom rng_;
 
     // -- member variables
     unsigned long long t_;
@@ -53,11 +71,19 @@ private:
     long H_cur_ = 0;
     long SL_cur_ = 0;
 
+    // -- skip-based sampling of the full SL: value of SL_cur_ at which the next light edge is admitted, and the
+    // -- running W of Algorithm L (0 until the reservoir fills)
+    bool sl_skip_sampling_ = false;
+    long SL_next_ = 0;
+    double SL_w_ = 0.0;
+
     int num_edges_;
 
     // -- triangle estimates
     double global_triangles_cnt_ = 0.0;
-    emhash5::HashMap<int, double> local_triangles_cnt_;
+    // -- local estimates, updated only if local counting is enabled at construction
+    const bool local_counting_;
+    LocalCounts local_triangles_cnt_;
 
     int get_heaviness(const int u, const int v);
 
@@ -71,6 +97,19 @@ private:
 
     inline double next_double();
 
+    void next_SL_skip();
+
+    inline void prefetch_edge(const StreamEdge &e) const {
+        subgraph_.prefetch_node(e.u);
+        subgraph_.prefetch_node(e.v);
+        if (oracle_) oracle_->prefetch(e.u, e.v);
+    }
+
+    inline void prefetch_neighbors(const StreamEdge &e) const {
+        subgraph_.prefetch_neighbors(e.u);
+        subgraph_.prefetch_neighbors(e.v);
+    }
+
 
 
 
@@ -81,29 +120,40 @@ public:
     double beta_;
     bool edge_oracle_flag_ = false;
 
-    constexpr static unsigned long long MAX_ID_NODE = 75000000;
-
     inline static unsigned long long edge_to_id(const int u, const int v) {
-        int nu = (u < v ? u : v);
-        int nv = (u < v ? v : u);
-        return (MAX_ID_NODE) * static_cast<unsigned long long>(nu) +
-               static_cast<unsigned long long>(nv);
+        return Utils::edge_to_id(u, v);
     }
 
-    Tonic(int random_seed, long k, double alpha, double beta);
+    Tonic(int random_seed, long k, double alpha, double beta, bool local_counting = false);
 
     ~Tonic();
 
-    void set_edge_oracle(emhash5::HashMap<long, int> &edge_oracle);
+    void set_oracle(std::shared_ptr<const Oracle> oracle);
 
-    void set_node_oracle(emhash5::HashMap<int, int> &node_oracle);
+    void set_hub_degree(uint32_t hub_degree);
+
+    void set_num_nodes(size_t num_nodes);
+
+    void set_sl_skip_sampling(bool sl_skip_sampling);
+
+    void set_colour_shard(std::shared_ptr<const ColourPartition> colours, int shard);
+
+    // -- process_edges prefetches the directory slots and the oracle slot of the edge 2 * PREFETCH_DISTANCE ahead of
+    // -- the current one, and the neighbors of the endpoints of the edge PREFETCH_DISTANCE ahead
+    constexpr static size_t PREFETCH_DISTANCE = 4;
 
     void process_edge(const int u, const int v);
 
+    void process_edges(std::span<const StreamEdge> edges);
+
     int get_num_nodes() const;
 
     int get_num_edges() const;
 
+    size_t get_subgraph_memory() const;
+
+    size_t get_random_draws() const;
+
     double get_local_triangles(const int u) const;
 
     void get_nodes(std::vector<int> &nodes) const;
@@ -112,7 +162,15 @@ public:
 
     void get_local_nodes(std::vector<int> &nodes) const;
 
-    inline unsigned long long get_edges_processed() const;
+    void get_top_local_triangles(size_t n, std::vector<std::pair<int, double>> &top_nodes) const;
+
+    inline bool local_counting() const { return local_counting_; }
+
+    inline size_t get_local_memory() const { return local_triangles_cnt_.memory_bytes(); }
+
+    inline unsigned long long get_edges_processed() const { return t_; }
+
+    inline const Oracle::Stats &get_oracle_stats() const { return oracle_stats_; }
 
 
 };
@@ -6,10 +6,15 @@
 #define TONIC_FD
 
 #include "hash_table5.hpp"
-#include "hash_set8.hpp"
 #include "FixedSizePQ.h"
+#include "LocalCounts.h"
+#include "Oracle.h"
+#include "Random.h"
+#include "SampledGraph.h"
 #include "Utils.h"
 #include <iostream>
+#include <memory>
+#include <span>
 #include <string>
 #include <random>
 #include <climits>
@@ -21,6 +26,11 @@ using Edge = Utils::Edge;
 
 private:
 
+    /**
+     * FIFO waiting room: edges are kept in arrival order in a circular array, with an index from edge id to slot.
+     * Deleted edges leave a tombstone, skipped when popping; the array has at least twice the maximum size, and is
+     * compacted when it fills up, so every operation takes amortized constant time.
+     */
     class WaitingRoom {
 
     using Edge = Utils::Edge;
@@ -28,26 +38,24 @@ private:
     private:
 
         inline static unsigned long long edge_to_wr_id(const int u, const int v) {
-            int nu = u < v ? u : v;
-            int nv = u < v ? v : u;
-            return static_cast<unsigned long long>(INT_MAX) * static_cast<unsigned long long>(nu) +
-                   static_cast<unsigned long long>(nv);
+            return Utils::edge_to_id(u, v);
         }
 
-        inline static Edge edge_wr_to_id(unsigned long long id) {
-            int u = (int) (id / INT_MAX);
-            int v = (int) (id % INT_MAX);
-            return {u, v};
-        }
+        constexpr static int TOMBSTONE = -1;
+
+        // -- circular array of edges, from position oldest_edge_idx_ (included) to next_edge_idx_ (excluded)
+        Edge* waiting_room_;
+        unsigned long long capacity_mask_;
+        unsigned long long next_edge_idx_;
+        // -- slot of each edge in the waiting room
+        emhash5::HashMap<unsigned long long, unsigned long long, Utils::hash_edge_id> edge_to_slot_;
 
-        // Edge* waiting_room_;
-        // emhash5::HashMap<long, long> edge_to_index_;
-        emhash8::HashSet<unsigned long long> waiting_room_;
+        void compact();
 
     public:
         long max_size_;
         long cur_size_;
-        long oldest_edge_idx_;
+        unsigned long long oldest_edge_idx_;
 
         WaitingRoom(long max_size);
 
@@ -63,7 +71,7 @@ private:
 
     };
 
-    emhash5::HashMap<int , emhash5::HashMap<int, bool>> subgraph_;
+    SampledGraph subgraph_;
 
     // -- heavy edge comparator -> return lightest edge
     struct heavy_edge_cmp {
@@ -72,23 +80,27 @@ private:
         }
     };
 
+    // -- heavy edge key -> edge id, to locate edges in the heap
+    struct heavy_edge_key {
+        unsigned long long operator()(const Heavy_edge &e) const {
+            return edge_to_id(e.first.first, e.first.second);
+        }
+    };
+
 
-    // -- oracles
-    emhash5::HashMap<int, int> node_oracle_;
-    emhash5::HashMap<long, int> edge_id_oracle_;
+    // -- oracle, shared with the other instances
+    std::shared_ptr<const Oracle> oracle_;
+    Oracle::Stats oracle_stats_;
 
     WaitingRoom* waiting_room_;
 
 
     // -- priority queue for all heavy edges
-    FixedSizePQ<Heavy_edge, heavy_edge_cmp> heavy_edges_;
-    // -- heavy edges set
-    emhash8::HashSet<unsigned long long> heavy_edges_set_;
+    IndexedFixedSizePQ<Heavy_edge, heavy_edge_cmp, heavy_edge_key, Utils::hash_edge_id> heavy_edges_;
 
     Edge* light_edges_sample_;
 
-    std::mt19937 gen_;
-    std::uniform_real_distribution<double> dis_;
+    TonicRandom rng_;
 
 
     // -- member variables
@@ -108,10 +120,12 @@ private:
 
     // -- triangle estimates
     double global_triangles_cnt_ = 0.0;
-    emhash5::HashMap<int, double> local_triangles_cnt_;
+    // -- signed local estimates, updated only if local counting is enabled at construction
+    const bool local_counting_;
+    LocalCounts local_triangles_cnt_;
 
     // -- edge to index
-    emhash5::HashMap<long, int> edge_id_to_index_;
+    emhash5::HashMap<long, int, Utils::hash_edge_id> edge_id_to_index_;
 
     int get_heaviness(const int u, const int v);
 
@@ -127,6 +141,16 @@ private:
 
     inline double next_double();
 
+    inline void prefetch_edge(const StreamEdge &e) const {
+        subgraph_.prefetch_node(e.u);
+        subgraph_.prefetch_node(e.v);
+        if (oracle_ and e.sign >= 0) oracle_->prefetch(e.u, e.v);
+    }
+
+    inline void prefetch_neighbors(const StreamEdge &e) const {
+        subgraph_.prefetch_neighbors(e.u);
+        subgraph_.prefetch_neighbors(e.v);
+    }
 
 
 public:
@@ -139,20 +163,32 @@ public:
     double alpha_, beta_;
     bool edge_oracle_flag_ = false;
 
-    Tonic_FD(int random_seed, long k, double alpha, double beta);
+    Tonic_FD(int random_seed, long k, double alpha, double beta, bool local_counting = false);
 
     ~Tonic_FD();
 
-    void set_edge_oracle(emhash5::HashMap<long, int> &edge_oracle);
+    void set_oracle(std::shared_ptr<const Oracle> oracle);
+
+    void set_hub_degree(uint32_t hub_degree);
 
-    void set_node_oracle(emhash5::HashMap<int, int> &node_oracle);
+    void set_num_nodes(size_t num_nodes);
+
+    // -- process_edges prefetches the directory slots and the oracle slot of the edge 2 * PREFETCH_DISTANCE ahead of
+    // -- the current one, and the neighbors of the endpoints of the edge PREFETCH_DISTANCE ahead
+    constexpr static size_t PREFETCH_DISTANCE = 4;
 
     void process_edge(const int u, const int v, const int t, const int sign);
 
+    void process_edges(std::span<const StreamEdge> edges);
+
     long get_num_nodes() const;
 
     long get_num_edges() const;
 
+    size_t get_subgraph_memory() const;
+
+    size_t get_random_draws() const;
+
     double get_local_triangles(const int u) const;
 
     void get_nodes(std::vector<int> &nodes) const;
@@ -161,7 +197,15 @@ public:
 
     void get_local_nodes(std::vector<int> &nodes) const;
 
-    inline unsigned long long get_edges_processed() const;
+    void get_top_local_triangles(size_t n, std::vector<std::pair<int, double>> &top_nodes) const;
+
+    inline bool local_counting() const { return local_counting_; }
+
+    inline size_t get_local_memory() const { return local_triangles_cnt_.memory_bytes(); }
+
+    inline unsigned long long get_edges_processed() const { return t_; }
+
+    inline const Oracle::Stats &get_oracle_stats() const { return oracle_stats_; }
 
 
 };
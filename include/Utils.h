@@ -2,6 +2,9 @@
 #define TONIC_UTILS_H
 
 #include "hash_table5.hpp"
+#include "EdgeStreamReader.h"
+#include "NodeRelabelling.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -15,13 +18,19 @@ class Utils {
 
 public:
 
-    constexpr static unsigned long long MAX_ID_NODE = 100000000;
-
+    /**
+     * Key of the undirected edge (u, v): the smaller endpoint in the high 32 bits and the larger in the low 32 bits, so
+     * that distinct edges of non-negative ids always get distinct keys, below 2^63
+     */
     inline static unsigned long long edge_to_id(const int u, const int v) {
         int nu = (u < v ? u : v);
         int nv = (u < v ? v : u);
-        return (MAX_ID_NODE) * static_cast<unsigned long long>(nu) +
-               static_cast<unsigned long long>(nv);
+        return (static_cast<unsigned long long>(static_cast<uint32_t>(nu)) << 32) |
+               static_cast<unsigned long long>(static_cast<uint32_t>(nv));
+    }
+
+    inline static std::pair<int, int> id_to_edge(const unsigned long long id) {
+        return {(int) (id >> 32), (int) (uint32_t) id};
     }
 
     struct hash_edge {
@@ -30,6 +39,19 @@ public:
         }
     };
 
+    /**
+     * Hash of the ids given by edge_to_id, for the emhash tables keyed by them: emhash buckets integer keys by their
+     * low bits, which hold only the larger endpoint, so the bits are mixed (splitmix64 finalizer) first
+     */
+    struct hash_edge_id {
+        inline size_t operator()(const unsigned long long id) const {
+            unsigned long long x = id;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+    };
+
     using Edge = std::pair<int, int>;
     using Heavy_edge = std::pair<Edge, int>;
     using EdgeTimestamped = std::pair<Edge, long>;
@@ -37,33 +59,41 @@ public:
     using EdgeStream = std::unordered_map<Edge, long, hash_edge>;
 
 
-    static long run_exact_algorithm(std::string &dataset_filepath,  std::string &output_path);
+    static long run_exact_algorithm(std::string &dataset_filepath, std::string &output_path, int num_threads,
+                                    const std::string &local_output_path = "");
 
-    static long run_exact_algorithm_FD(std::string &dataset_filepath, std::string &output_path);
+    static long run_exact_algorithm_FD(std::string &dataset_filepath, std::string &output_path,
+                                       long checkpoint_every = 0, const std::string &checkpoint_path = "");
 
     static bool read_node_oracle(std::string &oracle_filename, char delimiter, int skip,
                                  emhash5::HashMap<int, int> &node_oracle);
 
     static bool read_edge_oracle(std::string &oracle_filename, char delimiter, int skip,
-                                 emhash5::HashMap<long, int> &edge_id_oracle);
+                                 emhash5::HashMap<long, int, hash_edge_id> &edge_id_oracle);
+
+    static bool preprocess_data(const std::string &dataset_path, std::string &delimiter,
+                                int skip, std::string &output_path, bool binary_output = false,
+                                const std::string &mapping_path = "",
+                                NodeRelabelling::Strategy strategy = NodeRelabelling::Strategy::ID);
 
-    static void preprocess_data(const std::string &dataset_path, std::string &delimiter,
-                                int skip, std::string &output_path);
+    static bool relabel_oracle(const std::string &oracle_path, const std::string &oracle_type,
+                               const NodeRelabelling &relabelling, const std::string &output_path);
 
     static std::pair<EdgeStream, long> preprocess_data_FD(const std::string &dataset_path, std::string &delimiter,
                                                        int skip);
 
     static void merge_snapshots_FD(std::string &filepath, int n_snapshots, std::string &delimiter, int line_to_skip,
-                                   std::string &output_path);
+                                   std::string &output_path, bool binary_output = false);
 
-    static void build_edge_exact_oracle(std::string &filepath, double percentage_retain,
-                                  std::string &output_path);
+    static void build_edge_exact_oracle(std::string &filepath, double percentage_retain, std::string &output_path,
+                                        int num_threads, size_t chunk_edges, bool binary_output = false);
 
-    static void build_edge_exact_nowr_oracle(std::string &filepath, double percentage_retain,
-                                        std::string &output_path, int wr_size);
+    static void build_edge_exact_nowr_oracle(std::string &filepath, double percentage_retain, std::string &output_path,
+                                             int wr_size, int num_threads, size_t chunk_edges,
+                                             bool binary_output = false);
 
     static void build_node_oracle(std::string &filepath, double percentage_retain,
-                                        std::string &output_path);
+                                        std::string &output_path, bool binary_output = false);
 
 };
 
@@ -0,0 +1,508 @@
+//
+// Created by X on 16/10/24.
+//
+
+#include "Benchmark.h"
+#include "EdgeStreamReader.h"
+#include "FixedSizePQ.h"
+#include "GraphCSR.h"
+#include "NodeRelabelling.h"
+#include "Oracle.h"
+#include "hash_set8.hpp"
+#include "Random.h"
+#include "Tonic.h"
+#include "Tonic_FD.h"
+#include "Utils.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * Return the nanoseconds per iteration of f, called n times
+ */
+template<typename F>
+static double ns_per_call(size_t n, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double) n;
+}
+
+/**
+ * Time an engine: buffered uniform doubles (as used by Tonic), unbuffered ones, and bounded indices
+ * @param n_draws
+ * @param draws_per_edge random outputs drawn by Tonic per processed edge, 0 if no stream was run
+ */
+template<typename Engine>
+static void rng_engine_cost(size_t n_draws, double draws_per_edge) {
+    RandomSource<Engine> source(42);
+    Engine engine(42);
+    double sum = 0.0;
+    uint64_t idx = 0;
+    double buffered = ns_per_call(n_draws, [&]() { sum += source.next_double(); });
+    double unbuffered = ns_per_call(n_draws, [&]() { sum += bits_to_double(engine.next()); });
+    double index = ns_per_call(n_draws, [&]() { idx += source.next_index(1000003); });
+    printf("RNG %-14s || next_double %.2f ns (unbuffered %.2f ns) || next_index %.2f ns || %.2f ns/edge"
+           " [checksum %.3f %lu]\n", Engine::NAME, buffered, unbuffered, index, buffered * draws_per_edge,
+           sum, (unsigned long) idx);
+}
+
+/**
+ * Compare the cost of the random generators: xoshiro256**, PCG64 and Philox4x32, against std::mt19937 with
+ * uniform_real_distribution and the C rand() previously used by Tonic. If a stream is given, Tonic (with the engine
+ * selected at compile time, no oracle) is run on it first to measure how many random outputs it draws per edge, and
+ * the cost per processed edge of each generator is reported.
+ * @param dataset_path preprocessed stream, empty to time the generators only
+ * @param memory_budget memory budget of Tonic
+ */
+void Benchmark::rng(std::string &dataset_path, long memory_budget) {
+
+    double draws_per_edge = 0.0;
+    if (!dataset_path.empty()) {
+        std::vector<StreamEdge> edges;
+        EdgeStreamReader reader(dataset_path);
+        if (!reader.open()) return;
+        reader.for_each_edge([&](const StreamEdge &e) { edges.push_back(e); });
+
+        Tonic tonic(42, memory_budget, 0.1, 0.3);
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &e: edges) {
+            tonic.process_edge(e.u, e.v);
+        }
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        draws_per_edge = (double) tonic.get_random_draws() / (double) edges.size();
+        printf("Tonic (%s) || %zu edges in %.3f s (%.1f ns/edge) || %.4f random draws/edge || Estimated count"
+               " T = %f\n", TonicRandom::name(), edges.size(), time, time * 1e9 / (double) edges.size(),
+               draws_per_edge, tonic.get_global_triangles());
+    }
+
+    const size_t n_draws = 50000000;
+    rng_engine_cost<Xoshiro256ss>(n_draws, draws_per_edge);
+    rng_engine_cost<Pcg64>(n_draws, draws_per_edge);
+    rng_engine_cost<Philox4x32>(n_draws, draws_per_edge);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+    double sum = 0.0;
+    long idx = 0;
+    double mt = ns_per_call(n_draws, [&]() { sum += dis(gen); });
+    double crand = ns_per_call(n_draws, [&]() { idx += rand() % 1000003; });
+    printf("RNG %-14s || next_double %.2f ns || ns/edge %.2f [checksum %.3f]\n", "mt19937", mt, mt * draws_per_edge,
+           sum);
+    printf("RNG %-14s || next_index %.2f ns [checksum %ld]\n", "rand()", crand, idx);
+
+}
+
+/**
+ * Compare the heavy edge set of Tonic_FD kept with a binary heap plus a shadow set of live edges, where deleted edges
+ * are popped lazily once they reach the top, against the indexed 4-ary heap that erases them in place. The signed
+ * stream is replayed on a set of h heavy edges, with the heaviness of each edge given by a hash of its id.
+ * @param dataset_path preprocessed fully dynamic stream
+ * @param heavy_size maximum number of heavy edges
+ */
+void Benchmark::heap(std::string &dataset_path, long heavy_size) {
+
+    using Heavy_edge = Utils::Heavy_edge;
+    struct heavy_edge_cmp {
+        bool operator()(const Heavy_edge &a, const Heavy_edge &b) const { return a.second > b.second; }
+    };
+    struct heavy_edge_key {
+        unsigned long long operator()(const Heavy_edge &e) const {
+            return Utils::edge_to_id(e.first.first, e.first.second);
+        }
+    };
+    auto heaviness = [](int u, int v) {
+        uint64_t x = Utils::edge_to_id(u, v);
+        return (int) (splitmix64(x) >> 44);
+    };
+
+    std::vector<StreamEdge> edges;
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+    reader.for_each_edge([&](const StreamEdge &e) { edges.push_back(e); });
+    size_t deletions = 0;
+    for (const auto &e: edges) deletions += e.sign < 0;
+    printf("Stream || %zu events, %zu deletions || H size = %ld\n", edges.size(), deletions, heavy_size);
+
+    // -- lazy deletion: binary heap + set of the edges in H
+    {
+        FixedSizePQ<Heavy_edge, heavy_edge_cmp> heap(heavy_size);
+        emhash8::HashSet<unsigned long long, Utils::hash_edge_id> live(heavy_size);
+        size_t stale_pops = 0, peak = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &e: edges) {
+            unsigned long long id = Utils::edge_to_id(e.u, e.v);
+            if (e.sign < 0) {
+                live.erase(id);
+                continue;
+            }
+            int h = heaviness(e.u, e.v);
+            if ((long) live.size() < heavy_size) {
+                heap.push({{e.u, e.v}, h});
+                live.insert(id);
+            } else {
+                while (live.find(Utils::edge_to_id(heap.top().first.first, heap.top().first.second)) == live.end()) {
+                    heap.pop();
+                    stale_pops++;
+                }
+                if (h > heap.top().second) {
+                    live.erase(Utils::edge_to_id(heap.top().first.first, heap.top().first.second));
+                    heap.pop();
+                    heap.push({{e.u, e.v}, h});
+                    live.insert(id);
+                }
+            }
+            peak = std::max(peak, heap.size());
+        }
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Heap %-8s || %.1f ns/event || peak heap size %zu, final %zu || %zu stale pops\n", "lazy",
+               time * 1e9 / (double) edges.size(), peak, heap.size(), stale_pops);
+    }
+
+    // -- indexed 4-ary heap with in-place erase
+    {
+        IndexedFixedSizePQ<Heavy_edge, heavy_edge_cmp, heavy_edge_key, Utils::hash_edge_id> heap(heavy_size);
+        size_t peak = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &e: edges) {
+            if (e.sign < 0) {
+                heap.erase(Utils::edge_to_id(e.u, e.v));
+                continue;
+            }
+            int h = heaviness(e.u, e.v);
+            if ((long) heap.size() < heavy_size) {
+                heap.push({{e.u, e.v}, h});
+            } else if (h > heap.top().second) {
+                heap.replace_top({{e.u, e.v}, h});
+            }
+            peak = std::max(peak, heap.size());
+        }
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Heap %-8s || %.1f ns/event || peak heap size %zu, final %zu || %.2f moves/event\n", "indexed",
+               time * 1e9 / (double) edges.size(), peak, heap.size(), (double) heap.moves() / (double) edges.size());
+    }
+
+}
+
+/**
+ * Compare the oracle backends on the same oracle: the table as read (with and without a 12 bits/key blocked Bloom
+ * filter) and MPH tables with 8/16-bit fingerprints and heaviness. For each backend, report bytes per entry, lookup
+ * time of members and non-members, the rate of non-members reported as members, and the fraction of pairs of members
+ * with different heaviness whose order is kept. If a stream is given, Tonic is also run with each backend and the mean
+ * estimate over a few seeds reported.
+ * @param oracle_path text or binary oracle
+ * @param oracle_type nodes or edges
+ * @param dataset_path preprocessed insertion-only stream, empty to skip the Tonic runs
+ * @param memory_budget memory budget of Tonic
+ */
+void Benchmark::oracle(std::string &oracle_path, std::string &oracle_type, std::string &dataset_path,
+                       long memory_budget) {
+
+    bool edges = oracle_type == "edges";
+    auto load = [&]() {
+        if (Oracle::is_binary_file(oracle_path)) return Oracle::map_binary_oracle(oracle_path);
+        return edges ? Oracle::read_edge_oracle(oracle_path, ' ', 0) : Oracle::read_node_oracle(oracle_path, ' ', 0);
+    };
+    std::shared_ptr<const Oracle> table = load();
+    if (!table) return;
+
+    std::vector<std::pair<uint64_t, int>> entries;
+    table->get_entries(entries);
+    size_t n = entries.size();
+    printf("Oracle || %zu %s\n", n, oracle_type.c_str());
+    if (n < 2) return;
+
+    // -- random members, pairs of members and non-members
+    Xoshiro256ss engine(42);
+    const size_t n_lookups = 2000000;
+    std::vector<uint64_t> members(n_lookups), non_members;
+    for (auto &key: members) key = entries[engine.next() % n].first;
+    int max_node = 0;
+    for (const auto &entry: entries) {
+        max_node = std::max(max_node, (int) (edges ? Utils::id_to_edge(entry.first).second : entry.first));
+    }
+    while (non_members.size() < n_lookups) {
+        int u = (int) (engine.next() % (uint64_t) (2 * max_node + 2));
+        int v = (int) (engine.next() % (uint64_t) (2 * max_node + 2));
+        uint64_t key = edges ? Utils::edge_to_id(u, v) : (uint64_t) u;
+        if (table->get_heaviness(edges ? u : (int) key, edges ? v : (int) key) < 0) non_members.push_back(key);
+    }
+    std::vector<std::pair<size_t, size_t>> pairs;
+    while (pairs.size() < n_lookups) {
+        size_t a = engine.next() % n, b = engine.next() % n;
+        if (entries[a].second != entries[b].second) pairs.emplace_back(a, b);
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<const Oracle>>> backends;
+    backends.emplace_back("table", table);
+    std::shared_ptr<Oracle> filtered = load();
+    if (!filtered) return;
+    filtered->build_filter(12.0);
+    backends.emplace_back("table+bloom", filtered);
+    for (int fingerprint_bits: {8, 16}) {
+        for (int value_bits: {8, 16}) {
+            std::string name = "mph f" + std::to_string(fingerprint_bits) + " v" + std::to_string(value_bits);
+            backends.emplace_back(name, Oracle::build_mph_oracle(*table, fingerprint_bits, value_bits));
+        }
+    }
+    if (!edges) backends.emplace_back("dense", Oracle::build_dense_node_oracle(*table, (size_t) max_node + 1));
+
+    // -- heaviness of a node id or edge id
+    auto heaviness = [edges](const Oracle &oracle, uint64_t key) {
+        if (!edges) return oracle.get_heaviness((int) key, (int) key);
+        auto [u, v] = Utils::id_to_edge(key);
+        return oracle.get_heaviness(u, v);
+    };
+
+    for (const auto &backend: backends) {
+        const Oracle &oracle = *backend.second;
+        long checksum = 0;
+        size_t i = 0, false_positives = 0, kept = 0;
+        double member_ns = ns_per_call(n_lookups, [&]() { checksum += heaviness(oracle, members[i++]); });
+        i = 0;
+        double non_member_ns = ns_per_call(n_lookups, [&]() {
+            false_positives += heaviness(oracle, non_members[i++]) >= 0;
+        });
+        for (const auto &p: pairs) {
+            bool greater = entries[p.first].second > entries[p.second].second;
+            int ha = heaviness(oracle, entries[p.first].first), hb = heaviness(oracle, entries[p.second].first);
+            kept += greater ? ha > hb : ha < hb;
+        }
+        printf("Oracle %-12s || %6.2f bytes/entry || lookup %.1f ns (non-member %.1f ns) || false positives %.5f"
+               " || order kept %.5f [checksum %ld]\n", backend.first.c_str(),
+               (double) (oracle.memory_bytes() + oracle.filter_memory_bytes()) / (double) n, member_ns, non_member_ns,
+               (double) false_positives / (double) n_lookups, (double) kept / (double) pairs.size(), checksum);
+    }
+
+    if (dataset_path.empty()) return;
+    std::vector<StreamEdge> stream;
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+    reader.for_each_edge([&](const StreamEdge &e) { stream.push_back(e); });
+    const int n_seeds = 10;
+    for (const auto &backend: backends) {
+        double sum = 0.0, sum_sq = 0.0;
+        for (int seed = 0; seed < n_seeds; seed++) {
+            Tonic tonic(seed, memory_budget, 0.1, 0.3);
+            tonic.set_oracle(backend.second);
+            for (const auto &e: stream) tonic.process_edge(e.u, e.v);
+            double estimate = tonic.get_global_triangles();
+            sum += estimate;
+            sum_sq += estimate * estimate;
+        }
+        double mean = sum / n_seeds;
+        printf("Tonic %-12s || mean estimate %.1f || std %.1f over %d seeds\n", backend.first.c_str(), mean,
+               std::sqrt(std::max(0.0, sum_sq / n_seeds - mean * mean)), n_seeds);
+    }
+
+}
+
+/**
+ * Run a fresh instance (seed 42) on the stream with process_edges, in batches of batch_size edges (0: one
+ * process_edge call per edge, without prefetching)
+ * @return the edges per second and the final estimate
+ */
+template<typename Algo, typename ProcessEdge>
+static std::pair<double, double> batch_throughput(const std::vector<StreamEdge> &stream, size_t batch_size,
+                                                  long memory_budget, const std::shared_ptr<const Oracle> &oracle,
+                                                  ProcessEdge &&process_edge) {
+    Algo algo(42, memory_budget, 0.1, 0.3);
+    algo.set_oracle(oracle);
+    auto start = std::chrono::steady_clock::now();
+    if (batch_size == 0) {
+        for (const auto &e: stream) process_edge(algo, e);
+    } else {
+        for (size_t i = 0; i < stream.size(); i += batch_size) {
+            algo.process_edges(std::span<const StreamEdge>(stream.data() + i, std::min(batch_size, stream.size() - i)));
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {(double) stream.size() / seconds, algo.get_global_triangles()};
+}
+
+/**
+ * Throughput of Tonic (or Tonic_FD) against the batch size of process_edges, which prefetches the node entries and
+ * oracle slots of the upcoming edges of a batch. The stream is loaded in memory first, and each batch size runs fresh
+ * instances with the same seed (best of 3 runs), so all the estimates must equal the one of the edge-at-a-time
+ * baseline
+ * @param fully_dynamic true to run Tonic_FD
+ * @param dataset_path preprocessed stream
+ * @param oracle_path
+ * @param oracle_type nodes or edges
+ * @param memory_budget memory budget of Tonic
+ */
+void Benchmark::batch(bool fully_dynamic, std::string &dataset_path, std::string &oracle_path,
+                      std::string &oracle_type, long memory_budget) {
+
+    std::shared_ptr<const Oracle> oracle;
+    if (Oracle::is_binary_file(oracle_path)) {
+        oracle = Oracle::map_binary_oracle(oracle_path);
+    } else {
+        oracle = oracle_type == "edges" ? Oracle::read_edge_oracle(oracle_path, ' ', 0)
+                                        : Oracle::read_node_oracle(oracle_path, ' ', 0);
+    }
+    if (!oracle) return;
+
+    std::vector<StreamEdge> stream;
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+    reader.for_each_edge([&](const StreamEdge &e) { stream.push_back(e); });
+    printf("Stream || %zu edges || memory budget = %ld\n", stream.size(), memory_budget);
+
+    auto run = [&](size_t batch_size) {
+        if (fully_dynamic) {
+            return batch_throughput<Tonic_FD>(stream, batch_size, memory_budget, oracle,
+                                              [](Tonic_FD &algo, const StreamEdge &e) {
+                                                  algo.process_edge(e.u, e.v, e.t, e.sign);
+                                              });
+        }
+        return batch_throughput<Tonic>(stream, batch_size, memory_budget, oracle,
+                                       [](Tonic &algo, const StreamEdge &e) { algo.process_edge(e.u, e.v); });
+    };
+
+    // -- best of 3 runs, after a warm-up run faulting in the stream and a mapped oracle
+    auto best_run = [&](size_t batch_size) {
+        std::pair<double, double> best = run(batch_size);
+        for (int r = 1; r < 3; r++) {
+            auto result = run(batch_size);
+            if (result.first > best.first) best = result;
+        }
+        return best;
+    };
+    run(0);
+    auto [base_rate, base_estimate] = best_run(0);
+    printf("Batch %-8s || %.3f M edges/s || estimate %.3f\n", "edge", base_rate / 1e6, base_estimate);
+    for (size_t batch_size: {1, 4, 16, 64, 256, 1024, 4096, 65536}) {
+        auto [rate, estimate] = best_run(batch_size);
+        printf("Batch %-8zu || %.3f M edges/s (%.2fx) || estimate %.3f%s\n", batch_size, rate / 1e6,
+               rate / base_rate, estimate, estimate == base_estimate ? "" : " MISMATCH");
+    }
+
+}
+
+/**
+ * Throughput of Tonic and of the exact counter of RunExactAlgo (triangles of the degree-ordered CSR) under each
+ * relabelling strategy of DataPreprocessing, against the original ids. For each strategy the stream is relabelled in
+ * memory, the oracle (built on the original ids, if any) is relabelled with the same mapping, and the stream is
+ * written as a binary stream to scratch_path, from which the CSR is built. Times are the best of 3 runs
+ * @param dataset_path insertion-only stream
+ * @param memory_budget
+ * @param oracle_path empty to run Tonic without an oracle
+ * @param oracle_type nodes or edges
+ * @param scratch_path
+ */
+void Benchmark::relabel(std::string &dataset_path, long memory_budget, std::string &oracle_path,
+                        std::string &oracle_type, std::string &scratch_path) {
+
+    std::vector<StreamEdge> stream;
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+    reader.for_each_edge([&](const StreamEdge &e) { stream.push_back(e); });
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(stream.size());
+    for (const auto &e: stream) edges.emplace_back(e.u, e.v);
+
+    bool edge_oracle = oracle_type == "edges";
+    std::vector<std::pair<uint64_t, int>> oracle_entries;
+    if (!oracle_path.empty()) {
+        std::shared_ptr<Oracle> oracle = Oracle::is_binary_file(oracle_path) ? Oracle::map_binary_oracle(oracle_path)
+                                         : edge_oracle ? Oracle::read_edge_oracle(oracle_path, ' ', 0)
+                                                       : Oracle::read_node_oracle(oracle_path, ' ', 0);
+        if (!oracle) return;
+        oracle->get_entries(oracle_entries);
+    }
+    int num_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    printf("Stream || %zu edges || memory budget = %ld || oracle %zu %s\n", stream.size(), memory_budget,
+           oracle_entries.size(), oracle_path.empty() ? "(none)" : oracle_type.c_str());
+
+    auto best_of_3 = [](auto &&f) {
+        double best = f();
+        for (int r = 1; r < 3; r++) best = std::min(best, f());
+        return best;
+    };
+    auto seconds_of = [](auto &&f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // -- "original" keeps the ids of the stream
+    std::vector<std::pair<std::string, int>> strategies = {{"original", -1}};
+    for (auto strategy: {NodeRelabelling::Strategy::ID, NodeRelabelling::Strategy::DEGREE,
+                         NodeRelabelling::Strategy::FIRST, NodeRelabelling::Strategy::RCM}) {
+        strategies.emplace_back(NodeRelabelling::strategy_name(strategy), (int) strategy);
+    }
+    for (const auto &[name, strategy]: strategies) {
+        std::vector<StreamEdge> relabelled = stream;
+        std::vector<std::pair<uint64_t, int>> entries = oracle_entries;
+        double relabel_time = 0.0;
+        size_t num_nodes = 0;
+        if (strategy >= 0) {
+            NodeRelabelling relabelling;
+            relabel_time = seconds_of([&]() {
+                relabelling = NodeRelabelling::build(edges, (NodeRelabelling::Strategy) strategy);
+            });
+            for (auto &e: relabelled) {
+                int nu = relabelling.new_id(e.u), nv = relabelling.new_id(e.v);
+                e.u = std::min(nu, nv);
+                e.v = std::max(nu, nv);
+            }
+            relabelling.relabel_entries(edge_oracle, entries);
+            num_nodes = relabelling.num_nodes();
+        }
+
+        std::shared_ptr<const Oracle> oracle;
+        if (!oracle_path.empty() and edge_oracle) {
+            emhash5::HashMap<long, int, Utils::hash_edge_id> edge_id_oracle;
+            for (const auto &entry: entries) edge_id_oracle.insert_unique((long) entry.first, entry.second);
+            oracle = std::make_shared<Oracle>(std::move(edge_id_oracle));
+        } else if (!oracle_path.empty()) {
+            emhash5::HashMap<int, int> node_oracle;
+            for (const auto &entry: entries) node_oracle.insert_unique((int) entry.first, entry.second);
+            oracle = std::make_shared<Oracle>(std::move(node_oracle));
+        }
+
+        // -- Tonic, in batches as with the mmap reader: best of 3 runs after a warm-up run, whose rate is discarded
+        auto tonic_run = [&]() {
+            return batch_throughput<Tonic>(relabelled, EdgeStreamReader::DEFAULT_BATCH_SIZE, memory_budget, oracle,
+                                           [](Tonic &algo, const StreamEdge &e) { algo.process_edge(e.u, e.v); });
+        };
+        double estimate = tonic_run().second;
+        double rate = 0.0;
+        for (int r = 0; r < 3; r++) rate = std::max(rate, tonic_run().first);
+
+        // -- exact counter on the CSR of the relabelled stream
+        {
+            EdgeStreamWriter writer(scratch_path, true, false);
+            if (!writer.open()) return;
+            for (const auto &e: relabelled) writer.write(e.u, e.v, e.t);
+            if (!writer.close(num_nodes)) return;
+        }
+        GraphCSR graph;
+        bool ok = true;
+        double build_time = seconds_of([&]() {
+            ok = graph.build(scratch_path, GraphCSR::DEFAULT_CHUNK_EDGES, scratch_path);
+        });
+        std::remove(scratch_path.c_str());
+        if (!ok) return;
+        uint64_t triangles = 0;
+        auto count = [&](int threads) {
+            return best_of_3([&]() {
+                return seconds_of([&]() {
+                    triangles = graph.parallel_for_each_triangle(threads, [](int, int, int, uint64_t, uint64_t,
+                                                                             uint64_t) {});
+                });
+            });
+        };
+        double count_time = count(1);
+        double parallel_count_time = count(num_threads);
+
+        printf("Relabel %-8s || relabel %.3f s || Tonic %.3f M edges/s, estimate %.1f || exact: CSR %.3f s,"
+               " count %.3f s (1 thread), %.3f s (%d threads), T = %llu\n", name.c_str(), relabel_time, rate / 1e6,
+               estimate, build_time, count_time, parallel_count_time, num_threads, (unsigned long long) triangles);
+    }
+
+}
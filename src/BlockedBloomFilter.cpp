@@ -0,0 +1,24 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "BlockedBloomFilter.h"
+#include <algorithm>
+
+BlockedBloomFilter::BlockedBloomFilter(size_t n, double bits_per_key) {
+    size_t bits = (size_t) ((double) n * bits_per_key);
+    blocks_.assign(std::max<size_t>(1, (bits + 255) / 256), Block{});
+}
+
+/**
+ * Add key to the set
+ * @param key
+ */
+void BlockedBloomFilter::insert(uint64_t key) {
+    uint64_t h = mix(key);
+    Block &b = blocks_[block_index(h)];
+    auto x = (uint32_t) h;
+    for (int i = 0; i < 8; i++) {
+        b.words[i] |= 1u << ((x * SALT[i]) >> 27);
+    }
+}
@@ -0,0 +1,46 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "ColourPartition.h"
+#include <algorithm>
+
+ColourPartition::ColourPartition(int num_colours, uint64_t seed)
+        : num_colours_(std::max(1, std::min(num_colours, MAX_COLOURS))), seed_(seed) {
+
+    int c = num_colours_;
+    for (int x = 0; x < c; x++) {
+        for (int y = x; y < c; y++) {
+            for (int z = y; z < c; z++) {
+                triples_.insert(triples_.end(), {x, y, z});
+            }
+        }
+    }
+
+    pair_shards_.assign((size_t) c * c, {});
+    missing_.assign((size_t) num_shards() * c * c, -1);
+    for (int shard = 0; shard < num_shards(); shard++) {
+        const int *triple = &triples_[3 * shard];
+        // -- the pairs of a triple, with the remaining colour
+        int pairs[3][3] = {{triple[0], triple[1], triple[2]},
+                           {triple[0], triple[2], triple[1]},
+                           {triple[1], triple[2], triple[0]}};
+        for (const auto &pair: pairs) {
+            for (int k = 0; k < 2; k++) {
+                int a = k == 0 ? pair[0] : pair[1];
+                int b = k == 0 ? pair[1] : pair[0];
+                auto &shards = pair_shards_[a * c + b];
+                if (shards.empty() or shards.back() != shard) shards.push_back(shard);
+                missing_[((size_t) shard * c + a) * c + b] = (int8_t) pair[2];
+            }
+        }
+    }
+}
+
+double ColourPartition::edge_share(int shard) const {
+    const int *triple = &triples_[3 * shard];
+    double c2 = (double) num_colours_ * num_colours_;
+    if (triple[0] == triple[2]) return 1.0 / c2;
+    if (triple[0] == triple[1] or triple[1] == triple[2]) return 3.0 / c2;
+    return 6.0 / c2;
+}
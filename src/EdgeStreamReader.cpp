@@ -0,0 +1,376 @@
+//
+// Created by X on 12/10/24.
+//
+
+#include "EdgeStreamReader.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Convert an integer between host and little-endian byte order (the conversion is symmetric)
+ * @param x
+ * @return x in the other byte order, or x itself on little-endian hosts
+ */
+template<typename T>
+static inline T little_endian(T x) {
+    if constexpr (std::endian::native == std::endian::big) {
+        if constexpr (sizeof(T) == 8) return (T) __builtin_bswap64((uint64_t) x);
+        if constexpr (sizeof(T) == 4) return (T) __builtin_bswap32((uint32_t) x);
+    }
+    return x;
+}
+
+/**
+ * Convert all the fields of a binary stream header between host and little-endian byte order
+ * @param header
+ */
+static void header_little_endian(BinaryStreamHeader &header) {
+    header.version = little_endian(header.version);
+    header.flags = little_endian(header.flags);
+    header.num_nodes = little_endian(header.num_nodes);
+    header.num_edges = little_endian(header.num_edges);
+    header.max_node_id = little_endian(header.max_node_id);
+}
+
+/**
+ * Constructor for the EdgeStreamReader. The file is not opened until open() is called
+ * @param path of the preprocessed stream
+ */
+EdgeStreamReader::EdgeStreamReader(const std::string &path) : path_(path) {}
+
+/**
+ * Destructor for the EdgeStreamReader, unmaps the file
+ */
+EdgeStreamReader::~EdgeStreamReader() {
+    close();
+}
+
+/**
+ * Map the whole stream file in memory, advising the kernel for a sequential scan
+ * @return true if the file is mapped correctly, false otherwise
+ */
+bool EdgeStreamReader::open() {
+    close();
+    rows_ = 0;
+    failed_ = false;
+    fd_ = ::open(path_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Error! Unable to open file " << path_ << "\n";
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
+        std::cerr << "Error! Unable to stat file " << path_ << "\n";
+        close();
+        return false;
+    }
+
+    size_ = (size_t) st.st_size;
+    if (size_ == 0) {
+        // -- empty stream: nothing to map
+        return true;
+    }
+
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Error! Unable to mmap file " << path_ << "\n";
+        close();
+        return false;
+    }
+    madvise(addr, size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char *>(addr);
+    cur_ = data_;
+    end_ = data_ + size_;
+
+    // -- detect the binary format from the magic
+    if (size_ >= sizeof(BinaryStreamHeader) and
+        memcmp(data_, BinaryStreamHeader::MAGIC, sizeof(BinaryStreamHeader::MAGIC)) == 0) {
+        memcpy(&header_, data_, sizeof(BinaryStreamHeader));
+        header_little_endian(header_);
+        if (header_.version != BinaryStreamHeader::VERSION) {
+            std::cerr << "Error! Unsupported binary stream version " << header_.version << " in " << path_ << "\n";
+            close();
+            return false;
+        }
+        size_t expected = sizeof(BinaryStreamHeader) + header_.num_edges * header_.record_size();
+        if (expected > size_) {
+            std::cerr << "Error! Binary stream " << path_ << " is truncated\n";
+            close();
+            return false;
+        }
+        binary_ = true;
+        cur_ = data_ + sizeof(BinaryStreamHeader);
+        end_ = data_ + expected;
+    }
+    return true;
+}
+
+/**
+ * Check whether a file is a binary edge stream, by reading its magic
+ * @param path
+ * @return true if the file starts with the magic of the binary format, false otherwise
+ */
+bool EdgeStreamReader::is_binary_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BinaryStreamHeader::MAGIC)];
+    if (!file.read(magic, sizeof(magic))) return false;
+    return memcmp(magic, BinaryStreamHeader::MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * Unmap the file and close the descriptor
+ */
+void EdgeStreamReader::close() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    data_ = cur_ = end_ = nullptr;
+    size_ = 0;
+    binary_ = false;
+    header_ = BinaryStreamHeader{};
+}
+
+/**
+ * Parse a signed decimal integer starting at p
+ * @param p current position, pointing at the first digit or at the minus sign; moved right after the last parsed digit
+ * @param end of the mapped region
+ * @param value the parsed integer
+ * @return false if there is no digit at p, or the integer does not fit in an int
+ */
+inline bool EdgeStreamReader::parse_int(const char *&p, const char *end, int &value) {
+    bool negative = false;
+    if (p < end and *p == '-') {
+        negative = true;
+        p++;
+    }
+    const char *digits = p;
+    long acc = 0;
+    while (p < end and (unsigned) (*p - '0') < 10) {
+        acc = acc * 10 + (*p - '0');
+        if (acc > (long) INT_MAX + 1) return false;
+        p++;
+    }
+    if (p == digits or (!negative and acc > INT_MAX)) return false;
+    value = (int) (negative ? -acc : acc);
+    return true;
+}
+
+/**
+ * Parse at most max_edges rows of a text stream. Empty lines and comment lines (starting with # or %) are skipped; a
+ * row whose endpoints are not integers stops the stream with an error giving its row number
+ * @param batch where to store the parsed edges
+ * @param max_edges capacity of the batch
+ * @return the number of parsed edges, 0 at the end of the stream
+ */
+size_t EdgeStreamReader::next_text_batch(StreamEdge *batch, size_t max_edges) {
+
+    const char *p = cur_;
+    const char *end = end_;
+    size_t n = 0;
+
+    while (n < max_edges) {
+        // -- skip blank characters, empty lines and comments
+        while (p < end and (*p == ' ' or *p == '\t' or *p == '\n' or *p == '\r')) {
+            rows_ += *p == '\n';
+            p++;
+        }
+        if (p >= end) break;
+        if (*p == '#' or *p == '%') {
+            while (p < end and *p != '\n') p++;
+            continue;
+        }
+
+        StreamEdge &e = batch[n];
+        bool ok = parse_int(p, end, e.u);
+        while (p < end and (*p == ' ' or *p == '\t')) p++;
+        ok = ok and parse_int(p, end, e.v);
+        while (p < end and (*p == ' ' or *p == '\t')) p++;
+        e.t = 0;
+        if (ok and p < end and ((unsigned) (*p - '0') < 10 or (*p == '-' and p + 1 < end and
+                                                                 (unsigned) (p[1] - '0') < 10))) {
+            ok = parse_int(p, end, e.t);
+        }
+        if (!ok) {
+            std::cerr << "Error! Invalid row " << rows_ + 1 << " of " << path_ << ": expected u v [t] [sign]\n";
+            failed_ = true;
+            cur_ = end_;
+            return n;
+        }
+        while (p < end and (*p == ' ' or *p == '\t')) p++;
+        // -- by default, assume additions
+        e.sign = (p < end and *p == '-') ? -1 : 1;
+
+        // -- move to the next row
+        while (p < end and *p != '\n') p++;
+        n++;
+    }
+
+    cur_ = p;
+    return n;
+}
+
+/**
+ * Decode at most max_edges fixed-width records of a binary stream
+ * @param batch where to store the decoded edges
+ * @param max_edges capacity of the batch
+ * @return the number of decoded edges, 0 at the end of the stream
+ */
+size_t EdgeStreamReader::next_binary_batch(StreamEdge *batch, size_t max_edges) {
+
+    const size_t record_size = header_.record_size();
+    size_t n = std::min(max_edges, (size_t) (end_ - cur_) / record_size);
+    const char *p = cur_;
+    bool signed_stream = (header_.flags & BinaryStreamHeader::FLAG_SIGNED) != 0;
+
+    for (size_t i = 0; i < n; i++, p += record_size) {
+        int32_t fields[3];
+        memcpy(fields, p, sizeof(fields));
+        batch[i].u = little_endian(fields[0]);
+        batch[i].v = little_endian(fields[1]);
+        batch[i].t = little_endian(fields[2]);
+        batch[i].sign = (signed_stream and (int8_t) p[12] < 0) ? -1 : 1;
+    }
+
+    cur_ = p;
+    return n;
+}
+
+/**
+ * Read the next batch of edges from the stream, in stream order
+ * @param batch where to store the edges
+ * @param max_edges capacity of the batch
+ * @return the number of edges read, 0 at the end of the stream
+ */
+size_t EdgeStreamReader::next_batch(StreamEdge *batch, size_t max_edges) {
+    if (cur_ >= end_) return 0;
+    return binary_ ? next_binary_batch(batch, max_edges) : next_text_batch(batch, max_edges);
+}
+
+/**
+ * Constructor for the EdgeStreamWriter. The file is not created until open() is called
+ * @param path of the output stream
+ * @param binary true for the binary format, false for the text format
+ * @param signed_stream true if the stream is fully dynamic, i.e., each row carries a sign
+ */
+EdgeStreamWriter::EdgeStreamWriter(const std::string &path, bool binary, bool signed_stream) : path_(path),
+                                                                                            binary_(binary),
+                                                                                            signed_(signed_stream) {
+    buffer_.resize(1 << 20);
+}
+
+/**
+ * Destructor for the EdgeStreamWriter, closes the file if still open
+ */
+EdgeStreamWriter::~EdgeStreamWriter() {
+    if (file_ != nullptr) {
+        flush();
+        fclose(file_);
+    }
+}
+
+/**
+ * Create the output file. For the binary format, a placeholder header is written and patched by close()
+ * @return true if the file is created correctly, false otherwise
+ */
+bool EdgeStreamWriter::open() {
+    file_ = fopen(path_.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Error! Unable to create file " << path_ << "\n";
+        return false;
+    }
+    write_failed_ = false;
+    if (binary_) {
+        BinaryStreamHeader header{};
+        write_failed_ = fwrite(&header, sizeof(header), 1, file_) != 1;
+    }
+    return true;
+}
+
+/**
+ * Write the buffered rows to the file
+ */
+void EdgeStreamWriter::flush() {
+    if (buffer_len_ > 0) {
+        if (fwrite(buffer_.data(), 1, buffer_len_, file_) != buffer_len_) write_failed_ = true;
+        buffer_len_ = 0;
+    }
+}
+
+/**
+ * Append an edge to the stream
+ * @param u
+ * @param v
+ * @param t timestamp
+ * @param sign +1 for additions, -1 for deletions (ignored for insertion-only streams)
+ */
+void EdgeStreamWriter::write(int u, int v, int t, int sign) {
+
+    // -- a text row takes at most 3 * 11 digits, 3 delimiters, the sign and the newline
+    if (buffer_len_ + 40 > buffer_.size()) flush();
+    char *p = buffer_.data() + buffer_len_;
+
+    if (binary_) {
+        int32_t fields[3] = {little_endian((int32_t) u), little_endian((int32_t) v), little_endian((int32_t) t)};
+        memcpy(p, fields, sizeof(fields));
+        p += sizeof(fields);
+        if (signed_) *p++ = (char) (sign < 0 ? -1 : 1);
+    } else {
+        char *end = buffer_.data() + buffer_.size();
+        p = std::to_chars(p, end, u).ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, end, v).ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, end, t).ptr;
+        if (signed_) {
+            *p++ = ' ';
+            *p++ = sign < 0 ? '-' : '+';
+        }
+        *p++ = '\n';
+    }
+
+    buffer_len_ = (size_t) (p - buffer_.data());
+    num_edges_++;
+    max_node_id_ = std::max(max_node_id_, (uint64_t) std::max(u, v));
+}
+
+/**
+ * Flush and close the stream. For the binary format, the header is patched with the final counts
+ * @param num_nodes number of distinct nodes in the stream
+ * @return true if the stream is written correctly, false otherwise (including a failed write of earlier rows)
+ */
+bool EdgeStreamWriter::close(uint64_t num_nodes) {
+    if (file_ == nullptr) return false;
+    flush();
+    bool ok = !write_failed_;
+    if (binary_) {
+        BinaryStreamHeader header{};
+        memcpy(header.magic, BinaryStreamHeader::MAGIC, sizeof(header.magic));
+        header.version = BinaryStreamHeader::VERSION;
+        header.flags = signed_ ? BinaryStreamHeader::FLAG_SIGNED : 0;
+        header.num_nodes = num_nodes;
+        header.num_edges = num_edges_;
+        header.max_node_id = max_node_id_;
+        header_little_endian(header);
+        ok = fseek(file_, 0, SEEK_SET) == 0 and fwrite(&header, sizeof(header), 1, file_) == 1;
+    }
+    ok = (fclose(file_) == 0) and ok;
+    file_ = nullptr;
+    if (!ok) {
+        std::cerr << "Error! Unable to write file " << path_ << "\n";
+    }
+    return ok;
+}
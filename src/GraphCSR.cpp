@@ -0,0 +1,177 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "GraphCSR.h"
+#include "EdgeStreamReader.h"
+#include "hash_set8.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <queue>
+
+/**
+ * Key of the undirected edge (u, v), ordered by smaller then larger endpoint
+ */
+static inline uint64_t edge_key(int u, int v) {
+    int nu = u < v ? u : v;
+    int nv = u < v ? v : u;
+    return ((uint64_t) (uint32_t) nu << 32) | (uint32_t) nv;
+}
+
+static void sort_unique(std::vector<uint64_t> &keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+static bool write_run(const std::string &path, const std::vector<uint64_t> &keys) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error! Unable to open file " << path << "\n";
+        return false;
+    }
+    bool ok = fwrite(keys.data(), sizeof(uint64_t), keys.size(), file) == keys.size();
+    ok = fclose(file) == 0 and ok;
+    if (!ok) std::cerr << "Error! Unable to write file " << path << "\n";
+    return ok;
+}
+
+/**
+ * Apply f to the distinct keys of the sorted runs, in increasing order, with a k-way merge
+ * @return false if a run could not be read
+ */
+template<typename F>
+static bool merge_runs(const std::vector<std::string> &runs, F &&f) {
+    constexpr size_t BUFFER_KEYS = 1 << 14;
+    struct Run {
+        FILE *file;
+        std::vector<uint64_t> buffer;
+        size_t pos = 0, len = 0;
+    };
+    std::vector<Run> readers(runs.size());
+    auto refill = [&](Run &r) {
+        r.len = fread(r.buffer.data(), sizeof(uint64_t), BUFFER_KEYS, r.file);
+        r.pos = 0;
+        return r.len > 0;
+    };
+    using Head = std::pair<uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+    bool ok = true;
+    for (size_t i = 0; i < runs.size(); i++) {
+        readers[i].file = fopen(runs[i].c_str(), "rb");
+        readers[i].buffer.resize(BUFFER_KEYS);
+        if (readers[i].file == nullptr) {
+            std::cerr << "Error! Unable to open file " << runs[i] << "\n";
+            ok = false;
+        } else if (refill(readers[i])) {
+            heads.emplace(readers[i].buffer[0], i);
+        }
+    }
+    bool first = true;
+    uint64_t last = 0;
+    while (ok and !heads.empty()) {
+        auto [key, i] = heads.top();
+        heads.pop();
+        if (first or key != last) f(key);
+        first = false;
+        last = key;
+        Run &r = readers[i];
+        if (++r.pos < r.len or refill(r)) heads.emplace(r.buffer[r.pos], i);
+    }
+    for (auto &r: readers) {
+        if (r.file != nullptr) fclose(r.file);
+    }
+    return ok;
+}
+
+bool GraphCSR::build(const std::string &dataset_path, size_t chunk_edges, const std::string &spill_prefix) {
+
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return false;
+
+    // -- sort the distinct edges in chunks, spilling each full chunk as a sorted run
+    std::vector<uint64_t> chunk;
+    std::vector<std::string> runs;
+    chunk.reserve(std::min<size_t>(chunk_edges, 1 << 20));
+    emhash8::HashSet<int> nodes;
+    long skipped = 0;
+    bool ok = true;
+    stream_edges_ = 0;
+    ok = reader.for_each_edge([&](const StreamEdge &e) {
+        stream_edges_++;
+        if (e.u == e.v or !ok) return;
+        // -- nodes are relabelled from their ids packed in the edge keys, so edges with a negative id are not kept
+        if (e.u < 0 or e.v < 0) {
+            skipped++;
+            return;
+        }
+        nodes.insert(e.u);
+        nodes.insert(e.v);
+        chunk.push_back(edge_key(e.u, e.v));
+        if (chunk.size() >= chunk_edges) {
+            sort_unique(chunk);
+            runs.push_back(spill_prefix + ".run" + std::to_string(runs.size()));
+            ok = write_run(runs.back(), chunk);
+            chunk.clear();
+        }
+    }) and ok;
+    if (skipped > 0) std::cerr << "Warning! Skipped " << skipped << " edges with negative node ids\n";
+    relabelling_ = NodeRelabelling::from_nodes(std::vector<int>(nodes.begin(), nodes.end()));
+    emhash8::HashSet<int>().swap(nodes);
+    sort_unique(chunk);
+    if (ok and !runs.empty() and !chunk.empty()) {
+        runs.push_back(spill_prefix + ".run" + std::to_string(runs.size()));
+        ok = write_run(runs.back(), chunk);
+        std::vector<uint64_t>().swap(chunk);
+    }
+    if (!runs.empty()) {
+        printf("GraphCSR || spilled %zu sorted runs to %s.run*\n", runs.size(), spill_prefix.c_str());
+    }
+
+    // -- the relabelling keeps the order of the ids, so the keys in memory stay sorted once relabelled; the keys of the
+    // -- spilled runs are relabelled as they are merged
+    auto relabel = [&](uint64_t key) {
+        return edge_key(relabelling_.new_id((int) (key >> 32)), relabelling_.new_id((int) (uint32_t) key));
+    };
+    for (uint64_t &key: chunk) key = relabel(key);
+    auto for_each_edge = [&](auto &&f) {
+        if (runs.empty()) {
+            for (uint64_t key: chunk) f((int) (key >> 32), (int) (uint32_t) key);
+            return true;
+        }
+        return merge_runs(runs, [&](uint64_t key) {
+            key = relabel(key);
+            f((int) (key >> 32), (int) (uint32_t) key);
+        });
+    };
+
+    // -- degrees, then out-degrees in the degree order, then targets
+    degrees_.assign(relabelling_.num_nodes(), 0);
+    ok = ok and for_each_edge([&](int u, int v) {
+        degrees_[u]++;
+        degrees_[v]++;
+    });
+    offsets_.assign(degrees_.size() + 1, 0);
+    ok = ok and for_each_edge([&](int u, int v) { offsets_[(precedes(u, v) ? u : v) + 1]++; });
+    for (size_t u = 0; u < degrees_.size(); u++) offsets_[u + 1] += offsets_[u];
+    targets_.resize(offsets_.back());
+    std::vector<uint64_t> fill(offsets_.begin(), offsets_.end() - 1);
+    ok = ok and for_each_edge([&](int u, int v) {
+        if (precedes(u, v)) targets_[fill[u]++] = v;
+        else targets_[fill[v]++] = u;
+    });
+    for (size_t u = 0; u < degrees_.size(); u++) {
+        std::sort(targets_.begin() + (long) offsets_[u], targets_.begin() + (long) offsets_[u + 1]);
+    }
+
+    for (const auto &run: runs) std::remove(run.c_str());
+    return ok;
+}
+
+/**
+ * Return the bytes allocated by the graph
+ */
+size_t GraphCSR::memory_bytes() const {
+    return offsets_.capacity() * sizeof(uint64_t) + targets_.capacity() * sizeof(int) +
+           degrees_.capacity() * sizeof(uint32_t);
+}
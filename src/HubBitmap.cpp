@@ -0,0 +1,175 @@
+//
+// Created by X on 16/10/24.
+//
+
+#include "HubBitmap.h"
+
+/**
+ * Convert an array container into a bitmap container
+ * @param c
+ */
+void HubBitmap::to_bitmap(Container &c) {
+    c.bits.assign(BITMAP_WORDS, 0);
+    c.det.assign(BITMAP_WORDS, 0);
+    for (uint32_t x: c.array) {
+        uint32_t low = x & ID_MASK;
+        c.bits[low >> 6] |= 1ull << (low & 63);
+        if (x & DET_BIT) c.det[low >> 6] |= 1ull << (low & 63);
+    }
+    std::vector<uint32_t>().swap(c.array);
+}
+
+/**
+ * Convert a bitmap container into an array container
+ * @param c
+ */
+void HubBitmap::to_array(Container &c) {
+    std::vector<uint32_t> array;
+    array.reserve(c.cardinality);
+    for_each_in_container(c, [&](uint32_t low, bool det) { array.push_back(low | (det ? DET_BIT : 0)); });
+    c.array.swap(array);
+    std::vector<uint64_t>().swap(c.bits);
+    std::vector<uint64_t>().swap(c.det);
+}
+
+/**
+ * Insert id in the neighborhood, or update its det flag if already present
+ * @param id
+ * @param det
+ * @return true if id is new, false if it was already present
+ */
+bool HubBitmap::insert(uint32_t id, bool det) {
+    uint32_t key = id >> CHUNK_BITS;
+    uint32_t low = id & LOW_MASK;
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    size_t c = it - keys_.begin();
+    if (it == keys_.end() or *it != key) {
+        keys_.insert(it, key);
+        containers_.insert(containers_.begin() + (long) c, Container());
+    }
+    Container &cont = containers_[c];
+
+    if (cont.is_bitmap()) {
+        uint32_t w = low >> 6;
+        uint64_t bit = 1ull << (low & 63);
+        cont.det[w] = det ? (cont.det[w] | bit) : (cont.det[w] & ~bit);
+        if (cont.bits[w] & bit) return false;
+        cont.bits[w] |= bit;
+    } else {
+        uint32_t i = array_lower_bound(cont, low);
+        uint32_t entry = low | (det ? DET_BIT : 0);
+        if (i < cont.array.size() and (cont.array[i] & ID_MASK) == low) {
+            cont.array[i] = entry;
+            return false;
+        }
+        cont.array.insert(cont.array.begin() + i, entry);
+    }
+
+    cont.cardinality++;
+    cardinality_++;
+    if (!cont.is_bitmap() and cont.cardinality > ARRAY_MAX) {
+        to_bitmap(cont);
+    }
+    return true;
+}
+
+/**
+ * Remove id from the neighborhood
+ * @param id
+ * @param det set to the det flag of id
+ * @return true if id was found and removed, false otherwise
+ */
+bool HubBitmap::erase(uint32_t id, bool &det) {
+    long c = find_container(id >> CHUNK_BITS);
+    if (c < 0) return false;
+    Container &cont = containers_[c];
+    uint32_t low = id & LOW_MASK;
+
+    if (cont.is_bitmap()) {
+        uint32_t w = low >> 6;
+        uint64_t bit = 1ull << (low & 63);
+        if (!(cont.bits[w] & bit)) return false;
+        det = (cont.det[w] & bit) != 0;
+        cont.bits[w] &= ~bit;
+        cont.det[w] &= ~bit;
+    } else {
+        uint32_t i = array_lower_bound(cont, low);
+        if (i == cont.array.size() or (cont.array[i] & ID_MASK) != low) return false;
+        det = (cont.array[i] & DET_BIT) != 0;
+        cont.array.erase(cont.array.begin() + i);
+    }
+
+    cont.cardinality--;
+    cardinality_--;
+    if (cont.cardinality == 0) {
+        keys_.erase(keys_.begin() + c);
+        containers_.erase(containers_.begin() + c);
+    } else if (cont.is_bitmap() and cont.cardinality < ARRAY_MAX / 2) {
+        to_array(cont);
+    }
+    return true;
+}
+
+/**
+ * Remove all ids
+ */
+void HubBitmap::clear() {
+    keys_.clear();
+    containers_.clear();
+    cardinality_ = 0;
+}
+
+/**
+ * Return the bytes allocated by the containers
+ * @return allocated bytes
+ */
+size_t HubBitmap::memory_bytes() const {
+    size_t bytes = sizeof(HubBitmap) + keys_.capacity() * sizeof(uint32_t) + containers_.capacity() * sizeof(Container);
+    for (const auto &c: containers_) {
+        bytes += c.array.capacity() * sizeof(uint32_t) + (c.bits.capacity() + c.det.capacity()) * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+/**
+ * Count the common neighbors with other, split by the number of light edges among the two wedge edges. Pairs of
+ * bitmap containers are counted with AND and popcount, without visiting the ids
+ * @param other
+ * @param counts counts[i] is incremented by the number of common neighbors with i light wedge edges
+ */
+void HubBitmap::count_common(const HubBitmap &other, size_t counts[3]) const {
+    size_t i = 0, j = 0;
+    while (i < keys_.size() and j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            i++;
+        } else if (other.keys_[j] < keys_[i]) {
+            j++;
+        } else {
+            const Container &a = containers_[i++];
+            const Container &b = other.containers_[j++];
+            if (a.is_bitmap() and b.is_bitmap()) {
+                for (uint32_t w = 0; w < BITMAP_WORDS; w++) {
+                    uint64_t m = a.bits[w] & b.bits[w];
+                    if (!m) continue;
+                    uint64_t both_det = m & a.det[w] & b.det[w];
+                    uint64_t both_light = m & ~a.det[w] & ~b.det[w];
+                    int n = __builtin_popcountll(m);
+                    int n_det = __builtin_popcountll(both_det);
+                    int n_light = __builtin_popcountll(both_light);
+                    counts[0] += n_det;
+                    counts[2] += n_light;
+                    counts[1] += n - n_det - n_light;
+                }
+            } else {
+                // -- visit the array container, the smaller one if both are arrays
+                bool visit_a = !a.is_bitmap() and (b.is_bitmap() or a.cardinality <= b.cardinality);
+                const Container &array = visit_a ? a : b;
+                const Container &probe = visit_a ? b : a;
+                for (uint32_t x: array.array) {
+                    int s = container_status(probe, x & ID_MASK);
+                    if (s >= 0) counts[((x & DET_BIT) ? 0 : 1) + (s == 1 ? 0 : 1)]++;
+                }
+            }
+        }
+    }
+}
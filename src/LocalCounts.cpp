@@ -0,0 +1,53 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "LocalCounts.h"
+#include <algorithm>
+#include <climits>
+
+/**
+ * Grow the array to hold node id u >= 0: at least doubled, but never past the largest int id
+ */
+void LocalCounts::grow(int u) {
+    size_t size = std::max({2 * counts_.size(), (size_t) 1024, (size_t) u + 1});
+    counts_.resize(std::min(size, (size_t) INT_MAX + 1), 0.0);
+}
+
+/**
+ * Return the nodes with a non-zero estimate, in increasing order
+ * @param nodes to fill
+ */
+void LocalCounts::get_nodes(std::vector<int> &nodes) const {
+    nodes.clear();
+    for (size_t u = 0; u < counts_.size(); u++) {
+        if (counts_[u] != 0.0) nodes.push_back((int) u);
+    }
+}
+
+/**
+ * Return the n nodes with the largest positive estimates, by decreasing estimate (ties by id), with a bounded heap of
+ * n entries
+ * @param n 0 for all the nodes with a positive estimate
+ * @param top_nodes to fill with (node, estimate) pairs
+ */
+void LocalCounts::top(size_t n, std::vector<std::pair<int, double>> &top_nodes) const {
+    // -- heap ordered so that its top is the smallest of the kept estimates
+    auto heavier = [](const std::pair<int, double> &a, const std::pair<int, double> &b) {
+        return a.second > b.second or (a.second == b.second and a.first < b.first);
+    };
+    top_nodes.clear();
+    for (size_t u = 0; u < counts_.size(); u++) {
+        if (counts_[u] <= 0.0) continue;
+        std::pair<int, double> entry((int) u, counts_[u]);
+        if (n == 0 or top_nodes.size() < n) {
+            top_nodes.push_back(entry);
+            if (n > 0) std::push_heap(top_nodes.begin(), top_nodes.end(), heavier);
+        } else if (heavier(entry, top_nodes.front())) {
+            std::pop_heap(top_nodes.begin(), top_nodes.end(), heavier);
+            top_nodes.back() = entry;
+            std::push_heap(top_nodes.begin(), top_nodes.end(), heavier);
+        }
+    }
+    std::sort(top_nodes.begin(), top_nodes.end(), heavier);
+}
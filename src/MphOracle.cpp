@@ -0,0 +1,115 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "MphOracle.h"
+#include <algorithm>
+
+/**
+ * Mantissa bits of the quantized heaviness: values below 2^MANTISSA are stored exactly
+ */
+static int mantissa_bits(int bits) {
+    return bits == 8 ? 5 : 12;
+}
+
+MphOracle::MphOracle(const std::vector<std::pair<uint64_t, int>> &entries, int fingerprint_bits, int value_bits)
+        : fingerprint_bits_(fingerprint_bits), value_bits_(value_bits), size_(entries.size()) {
+
+    std::vector<uint64_t> keys;
+    keys.reserve(entries.size());
+    for (const auto &entry: entries) keys.push_back(entry.first);
+
+    // -- place the keys level by level: a key is placed in the first level where its position is not shared
+    uint64_t placed = 0;
+    std::vector<uint64_t> collisions;
+    for (int l = 0; l < MAX_LEVELS and !keys.empty(); l++) {
+        Level level;
+        level.size = std::max<uint64_t>(64, ((uint64_t) (GAMMA * (double) keys.size()) + 63) & ~63ull);
+        level.seed = 0x9E3779B97F4A7C15ull * (uint64_t) (l + 1);
+        level.offset = placed;
+        level.bits.assign(level.size / 64, 0);
+        collisions.assign(level.size / 64, 0);
+        for (uint64_t key: keys) {
+            uint64_t p = position(key, level);
+            uint64_t bit = 1ull << (p & 63);
+            if (level.bits[p >> 6] & bit) collisions[p >> 6] |= bit;
+            level.bits[p >> 6] |= bit;
+        }
+        for (size_t w = 0; w < level.bits.size(); w++) level.bits[w] &= ~collisions[w];
+
+        level.ranks.assign((level.bits.size() + RANK_BLOCK - 1) / RANK_BLOCK, 0);
+        uint32_t ones = 0;
+        for (size_t w = 0; w < level.bits.size(); w++) {
+            if (w % RANK_BLOCK == 0) level.ranks[w / RANK_BLOCK] = ones;
+            ones += __builtin_popcountll(level.bits[w]);
+        }
+        placed += ones;
+
+        std::vector<uint64_t> remaining;
+        for (uint64_t key: keys) {
+            uint64_t p = position(key, level);
+            if (!(level.bits[p >> 6] & (1ull << (p & 63)))) remaining.push_back(key);
+        }
+        keys.swap(remaining);
+        levels_.push_back(std::move(level));
+    }
+    for (uint64_t key: keys) fallback_.insert_unique(key, (uint32_t) placed++);
+
+    fingerprints_.assign(size_ * (fingerprint_bits_ / 8), 0);
+    values_.assign(size_ * (value_bits_ / 8), 0);
+    for (const auto &entry: entries) {
+        size_t i = slot(entry.first);
+        store(fingerprints_, i, fingerprint_bits_, fingerprint(entry.first, fingerprint_bits_));
+        store(values_, i, value_bits_, quantize(entry.second, value_bits_));
+    }
+}
+
+void MphOracle::store(std::vector<uint8_t> &data, size_t i, int bits, uint32_t x) {
+    if (bits == 8) {
+        data[i] = (uint8_t) x;
+    } else {
+        data[2 * i] = (uint8_t) x;
+        data[2 * i + 1] = (uint8_t) (x >> 8);
+    }
+}
+
+/**
+ * Monotone quantization of a heaviness on the given number of bits, as a small float: values below 2^M are kept
+ * exactly, larger ones keep their M most significant bits, with M = 5 on 8 bits and M = 12 on 16 bits. Values above
+ * the largest representable one are saturated
+ * @param heaviness non-negative heaviness
+ * @param bits 8 or 16
+ * @return code in [0, 2^bits)
+ */
+uint32_t MphOracle::quantize(int heaviness, int bits) {
+    int m = mantissa_bits(bits);
+    uint32_t max_code = (1u << bits) - 1;
+    uint64_t h = (uint64_t) std::max(heaviness, 0);
+    if (h < (1ull << m)) return (uint32_t) h;
+    int e = (64 - __builtin_clzll(h)) - m;
+    uint64_t code = ((uint64_t) e << (m - 1)) + (h >> e);
+    return (uint32_t) std::min<uint64_t>(code, max_code);
+}
+
+/**
+ * Inverse of quantize: return the smallest heaviness with the given code
+ */
+int MphOracle::dequantize(uint32_t code, int bits) {
+    int m = mantissa_bits(bits);
+    if (code < (1u << m)) return (int) code;
+    int e = (int) (code >> (m - 1)) - 1;
+    uint64_t mantissa = code - ((uint64_t) e << (m - 1));
+    return (int) std::min<uint64_t>(mantissa << e, (uint64_t) INT32_MAX);
+}
+
+/**
+ * Return the bytes used by the table
+ */
+size_t MphOracle::memory_bytes() const {
+    size_t bytes = sizeof(MphOracle) + fingerprints_.capacity() + values_.capacity() +
+                   fallback_.bucket_count() * (sizeof(uint64_t) + 2 * sizeof(uint32_t));
+    for (const auto &level: levels_) {
+        bytes += sizeof(Level) + level.bits.capacity() * sizeof(uint64_t) + level.ranks.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
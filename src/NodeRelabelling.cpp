@@ -0,0 +1,234 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "NodeRelabelling.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void NodeRelabelling::index_original_ids() {
+    new_ids_.clear();
+    new_ids_.reserve(original_ids_.size());
+    for (size_t u = 0; u < original_ids_.size(); u++) new_ids_.insert_unique(original_ids_[u], (int) u);
+}
+
+NodeRelabelling NodeRelabelling::build(const std::vector<std::pair<int, int>> &edges, Strategy strategy) {
+    NodeRelabelling relabelling;
+    std::vector<int> &ids = relabelling.original_ids_;
+
+    if (strategy == Strategy::FIRST) {
+        emhash5::HashMap<int, int> seen;
+        for (const auto &edge: edges) {
+            for (int u: {edge.first, edge.second}) {
+                if (seen.find(u) == seen.end()) {
+                    seen.insert_unique(u, 0);
+                    ids.push_back(u);
+                }
+            }
+        }
+        relabelling.index_original_ids();
+        return relabelling;
+    }
+
+    // -- the other orders start from the nodes by increasing id
+    std::vector<int> nodes;
+    nodes.reserve(2 * edges.size());
+    for (const auto &edge: edges) {
+        nodes.push_back(edge.first);
+        nodes.push_back(edge.second);
+    }
+    relabelling = from_nodes(std::move(nodes));
+    if (strategy == Strategy::ID) return relabelling;
+
+    // -- edges on the ids by increasing original id, then the permutation of the strategy
+    std::vector<std::pair<int, int>> dense_edges;
+    dense_edges.reserve(edges.size());
+    for (const auto &edge: edges) {
+        dense_edges.emplace_back(relabelling.new_id(edge.first), relabelling.new_id(edge.second));
+    }
+    std::vector<int> order;
+    if (strategy == Strategy::DEGREE) {
+        std::vector<uint32_t> degrees(ids.size(), 0);
+        for (const auto &edge: dense_edges) {
+            degrees[edge.first]++;
+            degrees[edge.second]++;
+        }
+        order.resize(ids.size());
+        for (size_t u = 0; u < order.size(); u++) order[u] = (int) u;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return degrees[a] > degrees[b]; });
+    } else {
+        order = rcm_order(dense_edges, ids.size());
+    }
+    std::vector<int> reordered(ids.size());
+    for (size_t u = 0; u < order.size(); u++) reordered[u] = ids[order[u]];
+    ids.swap(reordered);
+    relabelling.index_original_ids();
+    return relabelling;
+}
+
+NodeRelabelling NodeRelabelling::from_nodes(std::vector<int> nodes) {
+    NodeRelabelling relabelling;
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    nodes.shrink_to_fit();
+    relabelling.original_ids_ = std::move(nodes);
+    relabelling.index_original_ids();
+    return relabelling;
+}
+
+/**
+ * Reverse Cuthill-McKee order of the graph of the edges, with nodes in [0, num_nodes): each connected component is
+ * visited breadth-first from its node of minimum degree, enqueuing the unvisited neighbors of each node by increasing
+ * degree, and the whole order is reversed. Repeated edges are kept, as they do not change the order
+ * @return the nodes, in their new order
+ */
+std::vector<int> NodeRelabelling::rcm_order(const std::vector<std::pair<int, int>> &edges, size_t num_nodes) {
+    std::vector<uint64_t> offsets(num_nodes + 1, 0);
+    for (const auto &edge: edges) {
+        offsets[edge.first + 1]++;
+        offsets[edge.second + 1]++;
+    }
+    for (size_t u = 0; u < num_nodes; u++) offsets[u + 1] += offsets[u];
+    std::vector<int> adjacency(offsets.back());
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto &edge: edges) {
+        adjacency[fill[edge.first]++] = edge.second;
+        adjacency[fill[edge.second]++] = edge.first;
+    }
+    auto degree = [&](int u) { return offsets[u + 1] - offsets[u]; };
+    auto by_degree = [&](int a, int b) { return degree(a) < degree(b) or (degree(a) == degree(b) and a < b); };
+
+    std::vector<int> starts(num_nodes);
+    for (size_t u = 0; u < num_nodes; u++) starts[u] = (int) u;
+    std::sort(starts.begin(), starts.end(), by_degree);
+
+    std::vector<int> order;
+    order.reserve(num_nodes);
+    std::vector<bool> visited(num_nodes, false);
+    for (int start: starts) {
+        if (visited[start]) continue;
+        visited[start] = true;
+        order.push_back(start);
+        // -- order doubles as the queue of the visit
+        for (size_t head = order.size() - 1; head < order.size(); head++) {
+            int u = order[head];
+            size_t first = order.size();
+            for (uint64_t i = offsets[u]; i < offsets[u + 1]; i++) {
+                int w = adjacency[i];
+                if (visited[w]) continue;
+                visited[w] = true;
+                order.push_back(w);
+            }
+            std::sort(order.begin() + (long) first, order.end(), by_degree);
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+bool NodeRelabelling::parse_strategy(const std::string &name, Strategy &strategy) {
+    for (Strategy s: {Strategy::ID, Strategy::DEGREE, Strategy::FIRST, Strategy::RCM}) {
+        if (name == strategy_name(s)) {
+            strategy = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *NodeRelabelling::strategy_name(Strategy strategy) {
+    switch (strategy) {
+        case Strategy::DEGREE:
+            return "degree";
+        case Strategy::FIRST:
+            return "first";
+        case Strategy::RCM:
+            return "rcm";
+        default:
+            return "id";
+    }
+}
+
+/**
+ * Read a mapping written by write
+ * @param path
+ * @param relabelling
+ * @return false if the file could not be read, a row is not `new_id original_id`, or the new ids are not 0, 1, ... in
+ * order
+ */
+bool NodeRelabelling::read(const std::string &path, NodeRelabelling &relabelling) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error! Unable to open file " << path << "\n";
+        return false;
+    }
+    relabelling.original_ids_.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream row(line);
+        long new_id;
+        int original_id;
+        if (!(row >> new_id >> original_id) or !(row >> std::ws).eof() or
+            new_id != (long) relabelling.original_ids_.size()) {
+            std::cerr << "Error! Invalid mapping " << path << " at row " << relabelling.original_ids_.size() + 1
+                      << "\n";
+            return false;
+        }
+        relabelling.original_ids_.push_back(original_id);
+    }
+    if (file.bad()) {
+        std::cerr << "Error! Unable to read file " << path << "\n";
+        return false;
+    }
+    relabelling.index_original_ids();
+    return true;
+}
+
+/**
+ * Write the mapping as `new_id original_id` rows, by new id
+ * @param path
+ * @return true if the file was written
+ */
+bool NodeRelabelling::write(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "Error! Unable to open file " << path << "\n";
+        return false;
+    }
+    bool ok = true;
+    for (size_t u = 0; u < original_ids_.size() and ok; u++) {
+        ok = fprintf(file, "%zu %d\n", u, original_ids_[u]) > 0;
+    }
+    ok = fclose(file) == 0 and ok;
+    if (!ok) std::cerr << "Error! Unable to write file " << path << "\n";
+    return ok;
+}
+
+/**
+ * Translate the (key, label) entries of an oracle to the new ids: keys are node ids, or Utils::edge_to_id(u, v) for
+ * edge oracles. Entries with a node that is not relabelled (not in the stream) are dropped
+ * @param edges true for an edge oracle
+ * @param entries
+ */
+void NodeRelabelling::relabel_entries(bool edges, std::vector<std::pair<uint64_t, int>> &entries) const {
+    size_t kept = 0;
+    for (const auto &entry: entries) {
+        uint64_t key;
+        if (edges) {
+            auto [u, v] = Utils::id_to_edge(entry.first);
+            int nu = new_id(u), nv = new_id(v);
+            if (nu < 0 or nv < 0) continue;
+            key = Utils::edge_to_id(nu, nv);
+        } else {
+            int nu = new_id((int) entry.first);
+            if (nu < 0) continue;
+            key = (uint64_t) nu;
+        }
+        entries[kept++] = {key, entry.second};
+    }
+    entries.resize(kept);
+}
@@ -0,0 +1,294 @@
+//
+// Created by X on 17/10/24.
+//
+
+#include "Oracle.h"
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Oracle::Oracle(emhash5::HashMap<int, int> &&node_oracle) : type_(Type::NODES), backend_(Backend::HASH_MAP),
+                                                           node_oracle_(std::move(node_oracle)) {}
+
+Oracle::Oracle(emhash5::HashMap<long, int, Utils::hash_edge_id> &&edge_id_oracle)
+        : type_(Type::EDGES), backend_(Backend::HASH_MAP), edge_id_oracle_(std::move(edge_id_oracle)) {}
+
+Oracle::Oracle(Type type, std::unique_ptr<MphOracle> mph) : type_(type), backend_(Backend::MPH), mph_(std::move(mph)) {}
+
+Oracle::Oracle(std::vector<int32_t> &&dense_labels, size_t num_entries)
+        : type_(Type::NODES), backend_(Backend::DENSE), num_entries_(num_entries),
+          dense_labels_(std::move(dense_labels)) {}
+
+/**
+ * Oracle on a mapped binary oracle file, whose header has already been validated
+ * @param type
+ * @param mapping start of the mapped file
+ * @param mapping_size size of the mapped file
+ */
+Oracle::Oracle(Type type, void *mapping, size_t mapping_size) : type_(type), backend_(Backend::MAPPED),
+                                                                mapping_(mapping), mapping_size_(mapping_size) {
+    auto header = static_cast<const BinaryOracleHeader *>(mapping);
+    keys_ = reinterpret_cast<const uint64_t *>(header + 1);
+    labels_ = reinterpret_cast<const int32_t *>(keys_ + header->capacity);
+    mask_ = header->capacity - 1;
+    num_entries_ = header->num_entries;
+}
+
+Oracle::~Oracle() {
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+}
+
+/**
+ * Read a node oracle from file, with rows (u label)
+ * @param oracle_filename
+ * @param delimiter
+ * @param skip lines to skip at the beginning of the file
+ * @return the oracle, or nullptr if the file could not be read
+ */
+std::shared_ptr<Oracle> Oracle::read_node_oracle(std::string &oracle_filename, char delimiter, int skip) {
+    emhash5::HashMap<int, int> node_oracle;
+    if (!Utils::read_node_oracle(oracle_filename, delimiter, skip, node_oracle)) return nullptr;
+    return std::make_shared<Oracle>(std::move(node_oracle));
+}
+
+/**
+ * Read an edge oracle from file, with rows (u v label)
+ * @param oracle_filename
+ * @param delimiter
+ * @param skip lines to skip at the beginning of the file
+ * @return the oracle, or nullptr if the file could not be read
+ */
+std::shared_ptr<Oracle> Oracle::read_edge_oracle(std::string &oracle_filename, char delimiter, int skip) {
+    emhash5::HashMap<long, int, Utils::hash_edge_id> edge_id_oracle;
+    if (!Utils::read_edge_oracle(oracle_filename, delimiter, skip, edge_id_oracle)) return nullptr;
+    return std::make_shared<Oracle>(std::move(edge_id_oracle));
+}
+
+/**
+ * Map a binary oracle file (see BinaryOracleHeader) read-only. Nothing is parsed: pages of the table are loaded on
+ * demand by the lookups
+ * @param oracle_filename
+ * @return the oracle, or nullptr if the file could not be mapped or is not a valid binary oracle
+ */
+std::shared_ptr<Oracle> Oracle::map_binary_oracle(const std::string &oracle_filename) {
+    int fd = open(oracle_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error! Unable to open file " << oracle_filename << "\n";
+        return nullptr;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 or (size_t) st.st_size < sizeof(BinaryOracleHeader)) {
+        std::cerr << "Error! Invalid binary oracle " << oracle_filename << "\n";
+        close(fd);
+        return nullptr;
+    }
+    size_t size = (size_t) st.st_size;
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Error! Unable to mmap file " << oracle_filename << "\n";
+        return nullptr;
+    }
+
+    auto header = static_cast<const BinaryOracleHeader *>(addr);
+    if (memcmp(header->magic, BinaryOracleHeader::MAGIC, sizeof(header->magic)) == 0 and
+        header->version < BinaryOracleHeader::VERSION) {
+        std::cerr << "Error! Binary oracle " << oracle_filename << " uses an older key format, rebuild it\n";
+        munmap(addr, size);
+        return nullptr;
+    }
+    uint64_t capacity = header->capacity;
+    bool valid = memcmp(header->magic, BinaryOracleHeader::MAGIC, sizeof(header->magic)) == 0 and
+                 header->version == BinaryOracleHeader::VERSION and header->type <= (uint32_t) Type::EDGES and
+                 capacity > 0 and (capacity & (capacity - 1)) == 0 and header->num_entries < capacity and
+                 size == sizeof(BinaryOracleHeader) + capacity * (sizeof(uint64_t) + sizeof(int32_t));
+    if (!valid) {
+        std::cerr << "Error! Invalid binary oracle " << oracle_filename << "\n";
+        munmap(addr, size);
+        return nullptr;
+    }
+    madvise(addr, size, MADV_RANDOM);
+    return std::shared_ptr<Oracle>(new Oracle((Type) header->type, addr, size));
+}
+
+/**
+ * Check whether a file starts with the magic of the binary oracle format
+ * @param path
+ * @return true if the file is a binary oracle
+ */
+bool Oracle::is_binary_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BinaryOracleHeader::MAGIC)];
+    if (!file.read(magic, sizeof(magic))) return false;
+    return memcmp(magic, BinaryOracleHeader::MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * Build the open-addressed table of the given entries and write it as a binary oracle file
+ * @param path
+ * @param type
+ * @param entries (key, label) pairs with distinct keys: node ids, or Utils::edge_to_id(u, v) for edge oracles
+ * @return true if the file was written, false if it could not be or if a key is EMPTY_KEY
+ */
+bool Oracle::write_binary_oracle(const std::string &path, Type type,
+                                 const std::vector<std::pair<uint64_t, int>> &entries) {
+    for (const auto &entry: entries) {
+        if (entry.first == BinaryOracleHeader::EMPTY_KEY) {
+            std::cerr << "Error! Oracle key " << entry.first << " is reserved for empty slots\n";
+            return false;
+        }
+    }
+    uint64_t capacity = 2;
+    while (capacity < 2 * (uint64_t) entries.size()) capacity <<= 1;
+    uint64_t mask = capacity - 1;
+    std::vector<uint64_t> keys(capacity, BinaryOracleHeader::EMPTY_KEY);
+    std::vector<int32_t> labels(capacity, -1);
+    for (const auto &entry: entries) {
+        uint64_t i = BinaryOracleHeader::hash(entry.first) & mask;
+        while (keys[i] != BinaryOracleHeader::EMPTY_KEY and keys[i] != entry.first) i = (i + 1) & mask;
+        keys[i] = entry.first;
+        labels[i] = entry.second;
+    }
+
+    BinaryOracleHeader header{};
+    memcpy(header.magic, BinaryOracleHeader::MAGIC, sizeof(header.magic));
+    header.version = BinaryOracleHeader::VERSION;
+    header.type = (uint32_t) type;
+    header.num_entries = entries.size();
+    header.capacity = capacity;
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error! Unable to open file " << path << "\n";
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 and
+              fwrite(keys.data(), sizeof(uint64_t), capacity, file) == capacity and
+              fwrite(labels.data(), sizeof(int32_t), capacity, file) == capacity;
+    ok = fclose(file) == 0 and ok;
+    if (!ok) std::cerr << "Error! Unable to write file " << path << "\n";
+    return ok;
+}
+
+/**
+ * Build an MPH oracle (see MphOracle) with the entries of source
+ * @param source
+ * @param fingerprint_bits 8 or 16
+ * @param value_bits 8 or 16
+ * @return the oracle
+ */
+std::shared_ptr<Oracle> Oracle::build_mph_oracle(const Oracle &source, int fingerprint_bits, int value_bits) {
+    std::vector<std::pair<uint64_t, int>> entries;
+    source.get_entries(entries);
+    std::shared_ptr<Oracle> oracle(
+            new Oracle(source.type_, std::make_unique<MphOracle>(entries, fingerprint_bits, value_bits)));
+    if (source.filter_) oracle->build_filter(entries, source.filter_bits_per_key_);
+    return oracle;
+}
+
+/**
+ * Build a DENSE node oracle with the entries of source, for streams whose node ids are in [0, num_nodes) (see the
+ * relabelling of DataPreprocessing): lookups index an array of num_nodes labels, with no hashing and no filter
+ * @param source node oracle
+ * @param num_nodes
+ * @return the oracle, or nullptr if source is not a node oracle with listable entries, all with ids below num_nodes,
+ * or if num_nodes is beyond the range of node ids
+ */
+std::shared_ptr<Oracle> Oracle::build_dense_node_oracle(const Oracle &source, size_t num_nodes) {
+    if (source.type_ != Type::NODES or source.backend_ == Backend::MPH) return nullptr;
+    // -- node ids are non-negative ints, so a larger range would only allocate labels that are never read
+    if (num_nodes > (size_t) INT_MAX + 1) return nullptr;
+    std::vector<std::pair<uint64_t, int>> entries;
+    source.get_entries(entries);
+    std::vector<int32_t> labels(num_nodes, -1);
+    for (const auto &entry: entries) {
+        if (entry.first >= num_nodes) return nullptr;
+        labels[entry.first] = entry.second;
+    }
+    return std::shared_ptr<Oracle>(new Oracle(std::move(labels), entries.size()));
+}
+
+/**
+ * Build the blocked Bloom filter on the keys of the oracle. Must be called before the oracle is shared
+ * @param bits_per_key
+ * @return false if the keys of the oracle cannot be listed (MPH oracles: build the filter on the source instead)
+ */
+bool Oracle::build_filter(double bits_per_key) {
+    if (backend_ == Backend::MPH) return false;
+    std::vector<std::pair<uint64_t, int>> entries;
+    get_entries(entries);
+    build_filter(entries, bits_per_key);
+    return true;
+}
+
+void Oracle::build_filter(const std::vector<std::pair<uint64_t, int>> &entries, double bits_per_key) {
+    filter_ = std::make_unique<BlockedBloomFilter>(entries.size(), bits_per_key);
+    for (const auto &entry: entries) filter_->insert(entry.first);
+    filter_bits_per_key_ = bits_per_key;
+}
+
+/**
+ * Collect the (key, label) pairs of the oracle, keys as in the binary format. Not available for MPH oracles, which do
+ * not store their keys
+ * @param entries
+ */
+void Oracle::get_entries(std::vector<std::pair<uint64_t, int>> &entries) const {
+    entries.clear();
+    switch (backend_) {
+        case Backend::MAPPED:
+            for (uint64_t i = 0; i <= mask_; i++) {
+                if (keys_[i] != BinaryOracleHeader::EMPTY_KEY) entries.emplace_back(keys_[i], labels_[i]);
+            }
+            break;
+        case Backend::MPH:
+            std::cerr << "Error! The entries of an MPH oracle cannot be listed\n";
+            break;
+        case Backend::DENSE:
+            for (size_t u = 0; u < dense_labels_.size(); u++) {
+                if (dense_labels_[u] >= 0) entries.emplace_back((uint64_t) u, dense_labels_[u]);
+            }
+            break;
+        default:
+            for (const auto &elem: edge_id_oracle_) entries.emplace_back((uint64_t) elem.first, elem.second);
+            for (const auto &elem: node_oracle_) entries.emplace_back((uint64_t) elem.first, elem.second);
+    }
+}
+
+/**
+ * Return the number of nodes or edges in the oracle
+ */
+size_t Oracle::size() const {
+    switch (backend_) {
+        case Backend::MAPPED:
+        case Backend::DENSE:
+            return num_entries_;
+        case Backend::MPH:
+            return mph_->size();
+        default:
+            return type_ == Type::EDGES ? edge_id_oracle_.size() : node_oracle_.size();
+    }
+}
+
+/**
+ * Return the bytes used by the oracle tables (for MAPPED, the size of the mapped file)
+ */
+size_t Oracle::memory_bytes() const {
+    switch (backend_) {
+        case Backend::MAPPED:
+            return mapping_size_;
+        case Backend::MPH:
+            return mph_->memory_bytes();
+        case Backend::DENSE:
+            return dense_labels_.capacity() * sizeof(int32_t);
+        default:
+            // -- emhash5 buckets hold the key, the value and the next bucket index
+            return edge_id_oracle_.bucket_count() * (sizeof(long) + sizeof(int) + sizeof(uint32_t)) +
+                   node_oracle_.bucket_count() * (sizeof(int) + sizeof(int) + sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,110 @@
+//
+// Created by X on 14/10/24.
+//
+
+#include "PipelinedStreamReader.h"
+#include <chrono>
+
+/**
+ * Constructor for the PipelinedStreamReader. The producer thread is not started until start() is called
+ * @param path of the preprocessed stream
+ * @param batch_size number of edges parsed per batch
+ * @param ring_capacity number of batches that can be in flight between producer and consumer
+ */
+PipelinedStreamReader::PipelinedStreamReader(const std::string &path, size_t batch_size, size_t ring_capacity) :
+        path_(path), batch_size_(batch_size), ring_(ring_capacity) {
+    for (auto &batch: ring_.slots()) {
+        batch.edges.resize(batch_size_);
+    }
+}
+
+/**
+ * Destructor for the PipelinedStreamReader, waits for the producer to terminate
+ */
+PipelinedStreamReader::~PipelinedStreamReader() {
+    // -- drain the ring so that a producer blocked on a full ring can terminate
+    if (producer_.joinable()) {
+        size_t n;
+        while (next_batch(n) != nullptr);
+    }
+    join();
+}
+
+/**
+ * Open the stream and start the producer thread
+ * @return true if the stream is opened correctly, false otherwise
+ */
+bool PipelinedStreamReader::start() {
+    reader_ = std::make_unique<EdgeStreamReader>(path_);
+    if (!reader_->open()) return false;
+    producer_ = std::thread(&PipelinedStreamReader::produce, this);
+    return true;
+}
+
+/**
+ * Body of the producer thread: parse batches into the free slots of the ring, then publish an empty last batch
+ */
+void PipelinedStreamReader::produce() {
+
+    while (true) {
+        Batch *slot = ring_.producer_slot();
+        if (slot == nullptr) {
+            auto t0 = std::chrono::steady_clock::now();
+            while ((slot = ring_.producer_slot()) == nullptr) std::this_thread::yield();
+            producer_stall_time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        slot->size = reader_->next_batch(slot->edges.data(), batch_size_);
+        parse_time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        slot->last = slot->size == 0;
+        ring_.push();
+
+        if (slot->last) break;
+    }
+
+    bytes_read_ = reader_->bytes_read();
+    reader_->close();
+
+}
+
+/**
+ * Consumer side: release the previously returned batch and wait for the next one
+ * @param n set to the number of edges in the returned batch
+ * @return pointer to the edges of the next batch, nullptr at the end of the stream
+ */
+const StreamEdge *PipelinedStreamReader::next_batch(size_t &n) {
+
+    n = 0;
+    if (holding_batch_) {
+        ring_.pop();
+        holding_batch_ = false;
+    }
+    if (finished_) return nullptr;
+
+    Batch *slot = ring_.consumer_slot();
+    if (slot == nullptr) {
+        auto t0 = std::chrono::steady_clock::now();
+        while ((slot = ring_.consumer_slot()) == nullptr) std::this_thread::yield();
+        consumer_stall_time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    if (slot->last) {
+        ring_.pop();
+        finished_ = true;
+        return nullptr;
+    }
+
+    holding_batch_ = true;
+    n = slot->size;
+    return slot->edges.data();
+}
+
+/**
+ * Wait for the producer thread to terminate
+ */
+void PipelinedStreamReader::join() {
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+}
@@ -0,0 +1,438 @@
+//
+// Created by X on 15/10/24.
+//
+
+#include "SampledGraph.h"
+
+/**
+ * Constructor for the SampledGraph
+ * @param expected_nodes hint on the number of nodes, used to size the node directory
+ */
+SampledGraph::SampledGraph(size_t expected_nodes) {
+    table_log_ = 4;
+    while ((size_t) 7 << table_log_ < expected_nodes * 10) table_log_++;
+    table_.assign((size_t) 1 << table_log_, NodeEntry{EMPTY_NODE, 0, 0, 0, SMALL});
+}
+
+/**
+ * Set the degree at which a node becomes a hub with a bitmap neighborhood, 0 to disable hubs. Nodes are moved lazily,
+ * on their next insertion or deletion
+ * @param hub_degree
+ */
+void SampledGraph::set_hub_degree(uint32_t hub_degree) {
+    hub_degree_ = hub_degree == 0 ? UINT32_MAX : hub_degree;
+}
+
+/**
+ * Remove all nodes and edges, releasing the slab
+ */
+void SampledGraph::clear() {
+    table_.assign(table_.size(), NodeEntry{EMPTY_NODE, 0, 0, 0, SMALL});
+    num_nodes_ = 0;
+    num_edges_ = 0;
+    slab_.clear();
+    slab_.shrink_to_fit();
+    for (auto &blocks: free_blocks_) {
+        blocks.clear();
+    }
+    hubs_.clear();
+    free_hubs_.clear();
+}
+
+/**
+ * Return the block kind for a node with the given degree. Sorted blocks and bitmaps are kept down to half of their
+ * threshold, so that a node oscillating around it is not converted back and forth
+ * @param degree
+ * @param kind the current kind of the block
+ * @return the new kind of the block
+ */
+uint32_t SampledGraph::kind_for(uint32_t degree, uint32_t kind) const {
+    if (degree >= hub_degree_ or (kind == BITMAP and 2 * (uint64_t) degree >= hub_degree_)) return BITMAP;
+    if (degree <= SMALL_CAPACITY) return SMALL;
+    if (degree >= SORTED_MIN_DEGREE or (kind == SORTED and 2 * degree >= SORTED_MIN_DEGREE)) return SORTED;
+    return HASHED;
+}
+
+/**
+ * Return the smallest capacity log for a block holding degree neighbors: small and sorted blocks are filled up to
+ * their capacity, hashed blocks up to 3/4 of it
+ * @param degree
+ * @param kind
+ * @return the capacity log
+ */
+uint32_t SampledGraph::capacity_log_for(uint32_t degree, uint32_t kind) {
+    uint32_t cap_log = 1;
+    if (kind != HASHED) {
+        while ((1u << cap_log) < degree) cap_log++;
+    } else {
+        while ((3u << cap_log) < degree * 4) cap_log++;
+    }
+    return cap_log;
+}
+
+/**
+ * Double the node directory and reinsert all the nodes
+ */
+void SampledGraph::grow_table() {
+    std::vector<NodeEntry> old_table;
+    old_table.swap(table_);
+    table_log_++;
+    table_.assign((size_t) 1 << table_log_, NodeEntry{EMPTY_NODE, 0, 0, 0, SMALL});
+    size_t mask = table_.size() - 1;
+    for (const auto &e: old_table) {
+        if (e.node == EMPTY_NODE) continue;
+        size_t i = node_hash(e.node) >> (64 - table_log_);
+        while (table_[i].node != EMPTY_NODE) i = (i + 1) & mask;
+        table_[i] = e;
+    }
+}
+
+/**
+ * Return the directory entry of node u, creating it with an empty block if u is not in the subgraph
+ * @param u
+ * @return the entry of u, valid until the next insertion of a node
+ */
+SampledGraph::NodeEntry *SampledGraph::insert_node(int u) {
+    NodeEntry *e = find_node(u);
+    if (e != nullptr) return e;
+
+    if ((num_nodes_ + 1) * 10 > table_.size() * 7) {
+        grow_table();
+    }
+    size_t mask = table_.size() - 1;
+    size_t i = node_hash(u) >> (64 - table_log_);
+    while (table_[i].node != EMPTY_NODE) i = (i + 1) & mask;
+
+    uint32_t cap_log = capacity_log_for(1, SMALL);
+    uint64_t offset = allocate_block(cap_log);
+    table_[i] = NodeEntry{u, 0, offset, cap_log, SMALL};
+    num_nodes_++;
+    return &table_[i];
+}
+
+/**
+ * Remove a node from the directory, releasing its block. Entries after it in the probe sequence are shifted back
+ * @param e the entry of the node to remove
+ */
+void SampledGraph::erase_node(NodeEntry *e) {
+    if (e->kind == BITMAP) {
+        free_hub(e->offset);
+    } else {
+        free_block(e->offset, e->cap_log);
+    }
+    size_t mask = table_.size() - 1;
+    size_t i = (size_t) (e - table_.data());
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (table_[j].node == EMPTY_NODE) break;
+        size_t k = node_hash(table_[j].node) >> (64 - table_log_);
+        // -- move the entry at j into the hole at i unless its home slot lies cyclically in (i, j]
+        if ((i < j) ? (k <= i or k > j) : (k <= i and k > j)) {
+            table_[i] = table_[j];
+            i = j;
+        }
+    }
+    table_[i].node = EMPTY_NODE;
+    num_nodes_--;
+}
+
+/**
+ * Take a block of 2^cap_log slots from the free list, or from the end of the slab, and mark all its slots empty
+ * @param cap_log
+ * @return the offset of the block in the slab
+ */
+uint64_t SampledGraph::allocate_block(uint32_t cap_log) {
+    uint64_t offset;
+    auto &blocks = free_blocks_[cap_log];
+    if (!blocks.empty()) {
+        offset = blocks.back();
+        blocks.pop_back();
+    } else {
+        offset = slab_.size();
+        slab_.resize(offset + ((size_t) 1 << cap_log));
+    }
+    std::fill_n(slab_.data() + offset, (size_t) 1 << cap_log, EMPTY_SLOT);
+    return offset;
+}
+
+/**
+ * Give a block back to the free list of its size
+ * @param offset of the block in the slab
+ * @param cap_log
+ */
+void SampledGraph::free_block(uint64_t offset, uint32_t cap_log) {
+    free_blocks_[cap_log].push_back(offset);
+}
+
+/**
+ * Take an empty hub bitmap from the free list, or append a new one
+ * @return the index of the hub
+ */
+uint64_t SampledGraph::allocate_hub() {
+    if (!free_hubs_.empty()) {
+        uint64_t hub = free_hubs_.back();
+        free_hubs_.pop_back();
+        return hub;
+    }
+    hubs_.emplace_back();
+    return hubs_.size() - 1;
+}
+
+/**
+ * Empty a hub bitmap and give it back to the free list
+ * @param hub
+ */
+void SampledGraph::free_hub(uint64_t hub) {
+    hubs_[hub].clear();
+    free_hubs_.push_back(hub);
+}
+
+/**
+ * Move the neighbors of a node into a new block of the given kind, of 2^new_cap_log slots unless it is a bitmap
+ * @param e the entry of the node
+ * @param new_kind
+ * @param new_cap_log
+ */
+void SampledGraph::rebuild_block(NodeEntry &e, uint32_t new_kind, uint32_t new_cap_log) {
+    NodeEntry old = e;
+    if (new_kind == BITMAP) {
+        uint64_t hub = allocate_hub();
+        for_each_neighbor(old, [&](uint32_t x) { hubs_[hub].insert(x & ID_MASK, (x & DET_BIT) != 0); });
+        free_block(old.offset, old.cap_log);
+        e.offset = hub;
+        e.cap_log = 0;
+        e.kind = BITMAP;
+        return;
+    }
+
+    // -- the allocation may move the slab: read the old block only after it
+    e.offset = allocate_block(new_cap_log);
+    e.cap_log = new_cap_log;
+    e.kind = new_kind;
+    uint32_t *nb = neighbors(e);
+    uint32_t n = 0;
+    uint32_t mask = (1u << new_cap_log) - 1;
+    for_each_neighbor(old, [&](uint32_t x) {
+        if (is_hashed(e)) {
+            uint32_t j = neighbor_home(x & ID_MASK, new_cap_log);
+            while (nb[j] != EMPTY_SLOT) j = (j + 1) & mask;
+            nb[j] = x;
+        } else {
+            nb[n++] = x;
+        }
+    });
+    // -- bitmaps are visited in id order, already sorted
+    if (e.kind == SORTED and old.kind != SORTED and old.kind != BITMAP) {
+        std::sort(nb, nb + n, [](uint32_t x, uint32_t y) { return (x & ID_MASK) < (y & ID_MASK); });
+    }
+    if (old.kind == BITMAP) {
+        free_hub(old.offset);
+    } else {
+        free_block(old.offset, old.cap_log);
+    }
+}
+
+/**
+ * Insert a neighbor entry in the block of a node, or update its flag if already present
+ * @param e the entry of the node
+ * @param entry neighbor id with the det flag
+ * @return true if the neighbor is new, false if it was already present
+ */
+bool SampledGraph::insert_neighbor(NodeEntry &e, uint32_t entry) {
+    uint32_t w = entry & ID_MASK;
+    if (e.kind == BITMAP) {
+        if (!hubs_[e.offset].insert(w, (entry & DET_BIT) != 0)) return false;
+        e.degree++;
+        return true;
+    }
+
+    long slot = find_neighbor(e, w);
+    if (slot >= 0) {
+        neighbors(e)[slot] = entry;
+        return false;
+    }
+
+    uint32_t kind = kind_for(e.degree + 1, e.kind);
+    if (kind == BITMAP) {
+        rebuild_block(e, BITMAP, 0);
+        hubs_[e.offset].insert(w, (entry & DET_BIT) != 0);
+        e.degree++;
+        return true;
+    }
+    uint32_t needed = capacity_log_for(e.degree + 1, kind);
+    if (kind != e.kind or needed > e.cap_log) {
+        rebuild_block(e, kind, needed);
+    }
+
+    uint32_t *nb = neighbors(e);
+    if (e.kind == HASHED) {
+        uint32_t mask = (1u << e.cap_log) - 1;
+        uint32_t i = neighbor_home(w, e.cap_log);
+        while (nb[i] != EMPTY_SLOT) i = (i + 1) & mask;
+        nb[i] = entry;
+    } else if (e.kind == SORTED) {
+        uint32_t i = sorted_lower_bound(nb, e.degree, w);
+        std::copy_backward(nb + i, nb + e.degree, nb + e.degree + 1);
+        nb[i] = entry;
+    } else {
+        nb[e.degree] = entry;
+    }
+    e.degree++;
+    return true;
+}
+
+/**
+ * Remove a neighbor from the block of a node, shrinking the block when it becomes sparse
+ * @param e the entry of the node
+ * @param w the neighbor to remove
+ * @param det set to the flag of the removed neighbor
+ * @return true if the neighbor was found and removed, false otherwise
+ */
+bool SampledGraph::erase_neighbor(NodeEntry &e, uint32_t w, bool &det) {
+    if (e.kind == BITMAP) {
+        if (!hubs_[e.offset].erase(w, det)) return false;
+        e.degree--;
+        if (e.degree > 0 and kind_for(e.degree, BITMAP) != BITMAP) {
+            uint32_t kind = kind_for(e.degree, BITMAP);
+            rebuild_block(e, kind, capacity_log_for(e.degree, kind));
+        }
+        return true;
+    }
+
+    long slot = find_neighbor(e, w);
+    if (slot < 0) return false;
+
+    uint32_t *nb = neighbors(e);
+    det = (nb[slot] & DET_BIT) != 0;
+    if (e.kind == HASHED) {
+        uint32_t mask = (1u << e.cap_log) - 1;
+        uint32_t i = (uint32_t) slot;
+        uint32_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (nb[j] == EMPTY_SLOT) break;
+            uint32_t k = neighbor_home(nb[j] & ID_MASK, e.cap_log);
+            if ((i < j) ? (k <= i or k > j) : (k <= i and k > j)) {
+                nb[i] = nb[j];
+                i = j;
+            }
+        }
+        nb[i] = EMPTY_SLOT;
+    } else if (e.kind == SORTED) {
+        std::copy(nb + slot + 1, nb + e.degree, nb + slot);
+        nb[e.degree - 1] = EMPTY_SLOT;
+    } else {
+        nb[slot] = nb[e.degree - 1];
+        nb[e.degree - 1] = EMPTY_SLOT;
+    }
+    e.degree--;
+
+    if (e.degree > 0) {
+        uint32_t kind = kind_for(e.degree, e.kind);
+        uint32_t needed = capacity_log_for(e.degree, kind);
+        if (kind != e.kind or needed + 2 <= e.cap_log) {
+            rebuild_block(e, kind, needed);
+        }
+    }
+    return true;
+}
+
+/**
+ * Add edge (u, v) to the subgraph, or update its flag if already present
+ * @param u
+ * @param v
+ * @param det true if the edge is deterministic (heavy or WR), false otherwise (light, in SL)
+ * @return true if the edge is new, false if it was already in the subgraph or an endpoint is not a valid id
+ */
+bool SampledGraph::add_edge(int u, int v, bool det) {
+    if (!valid_id(u) or !valid_id(v)) return false;
+    uint32_t flag = det ? DET_BIT : 0;
+    // -- insert_node may move the directory: update u before looking up v
+    bool is_new = insert_neighbor(*insert_node(u), (uint32_t) v | flag);
+    insert_neighbor(*insert_node(v), (uint32_t) u | flag);
+    if (is_new) num_edges_++;
+    return is_new;
+}
+
+/**
+ * Remove edge (u, v) from the subgraph. Nodes left without neighbors are removed as well
+ * @param u
+ * @param v
+ * @param det set to the flag of the removed edge
+ * @return true if the edge was found and removed, false otherwise
+ */
+bool SampledGraph::remove_edge(int u, int v, bool &det) {
+    NodeEntry *eu = find_node(u);
+    if (eu == nullptr or !erase_neighbor(*eu, (uint32_t) v, det)) return false;
+    if (eu->degree == 0) erase_node(eu);
+
+    NodeEntry *ev = find_node(v);
+    bool v_det;
+    if (ev != nullptr and erase_neighbor(*ev, (uint32_t) u, v_det)) {
+        if (ev->degree == 0) erase_node(ev);
+    }
+    num_edges_--;
+    return true;
+}
+
+/**
+ * Remove edge (u, v) from the subgraph. Nodes left without neighbors are removed as well
+ * @param u
+ * @param v
+ * @return true if the edge was found and removed, false otherwise
+ */
+bool SampledGraph::remove_edge(int u, int v) {
+    bool det;
+    return remove_edge(u, v, det);
+}
+
+/**
+ * Return the nodes in the subgraph
+ * @param nodes to fill
+ */
+void SampledGraph::get_nodes(std::vector<int> &nodes) const {
+    nodes.clear();
+    nodes.reserve(num_nodes_);
+    for (const auto &e: table_) {
+        if (e.node != EMPTY_NODE) nodes.push_back(e.node);
+    }
+}
+
+/**
+ * Count the common neighbors w of u and v, split by the number of light edges among (u, w) and (v, w). Two hubs are
+ * counted with bitmap AND and popcount
+ * @param u
+ * @param v
+ * @param counts counts[i] is set to the number of common neighbors with i light wedge edges
+ */
+void SampledGraph::count_common_neighbors(int u, int v, size_t counts[3]) const {
+    counts[0] = counts[1] = counts[2] = 0;
+    const NodeEntry *eu = find_node(u);
+    const NodeEntry *ev = find_node(v);
+    if (eu != nullptr and ev != nullptr and eu->kind == BITMAP and ev->kind == BITMAP) {
+        hubs_[eu->offset].count_common(hubs_[ev->offset], counts);
+        return;
+    }
+    for_each_common_neighbor(u, v, [&](int, bool uw_det, bool vw_det) {
+        counts[(uw_det ? 0 : 1) + (vw_det ? 0 : 1)]++;
+    });
+}
+
+/**
+ * Return the bytes allocated by the subgraph: node directory, neighbor slab, hub bitmaps and free lists
+ * @return allocated bytes
+ */
+size_t SampledGraph::memory_bytes() const {
+    size_t bytes = sizeof(SampledGraph) + table_.capacity() * sizeof(NodeEntry) + slab_.capacity() * sizeof(uint32_t) +
+                   (common_u_.capacity() + common_v_.capacity()) * sizeof(uint32_t);
+    for (const auto &blocks: free_blocks_) {
+        bytes += blocks.capacity() * sizeof(uint64_t);
+    }
+    for (const auto &hub: hubs_) {
+        bytes += hub.memory_bytes();
+    }
+    bytes += hubs_.capacity() * sizeof(HubBitmap) - hubs_.size() * sizeof(HubBitmap) +
+             free_hubs_.capacity() * sizeof(uint64_t);
+    return bytes;
+}
@@ -0,0 +1,205 @@
+//
+// Created by X on 16/10/24.
+//
+
+#include "SortedIntersect.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+const char *SortedIntersect::kernel_name_ = "scalar";
+SortedIntersect::Kernel SortedIntersect::kernel_ = SortedIntersect::select_kernel();
+
+/**
+ * Pick the widest kernel supported by the CPU
+ * @return the kernel used by intersect
+ */
+SortedIntersect::Kernel SortedIntersect::select_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernel_name_ = "avx2";
+        return &intersect_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        kernel_name_ = "sse4.1";
+        return &intersect_sse4;
+    }
+#endif
+    kernel_name_ = "scalar";
+    return &intersect_scalar;
+}
+
+/**
+ * Return the name of the kernel selected for this CPU
+ */
+const char *SortedIntersect::kernel_name() {
+    return kernel_name_;
+}
+
+/**
+ * Intersect two arrays sorted by id (entry & ID_MASK), without repeated ids
+ * @param a
+ * @param na
+ * @param b
+ * @param nb
+ * @param out_a filled with the entries of a whose id is in b, at least min(na, nb) slots
+ * @param out_b filled with the matching entries of b, in the same order
+ * @return the number of common ids
+ */
+size_t SortedIntersect::intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out_a,
+                                  uint32_t *out_b) {
+    if (na == 0 or nb == 0) return 0;
+    if (nb > GALLOP_RATIO * na) return intersect_gallop(a, na, b, nb, out_a, out_b);
+    if (na > GALLOP_RATIO * nb) return intersect_gallop(b, nb, a, na, out_b, out_a);
+    return kernel_(a, na, b, nb, out_a, out_b);
+}
+
+/**
+ * Scalar merge of the two arrays
+ */
+size_t SortedIntersect::intersect_scalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                                         uint32_t *out_a, uint32_t *out_b) {
+    size_t i = 0, j = 0, n = 0;
+    while (i < na and j < nb) {
+        uint32_t x = a[i] & ID_MASK;
+        uint32_t y = b[j] & ID_MASK;
+        if (x < y) {
+            i++;
+        } else if (y < x) {
+            j++;
+        } else {
+            out_a[n] = a[i++];
+            out_b[n] = b[j++];
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * Look up each entry of the (much smaller) array a in b by exponential search followed by a binary search, starting
+ * from the position of the previous match
+ */
+size_t SortedIntersect::intersect_gallop(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                                         uint32_t *out_a, uint32_t *out_b) {
+    size_t j = 0, n = 0;
+    for (size_t i = 0; i < na and j < nb; i++) {
+        uint32_t x = a[i] & ID_MASK;
+        // -- find lo < hi with b[lo] < x <= b[hi], or hi = nb
+        size_t step = 1, lo = j, hi = j;
+        while (hi < nb and (b[hi] & ID_MASK) < x) {
+            lo = hi;
+            hi += step;
+            step <<= 1;
+        }
+        if (hi > nb) hi = nb;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if ((b[mid] & ID_MASK) < x) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        j = lo;
+        if (j < nb and (b[j] & ID_MASK) == x) {
+            out_a[n] = a[i];
+            out_b[n] = b[j++];
+            n++;
+        }
+    }
+    return n;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Write out the matches found between a block of a and a block of b
+ * @param mask bit k set if a[k] has a match in the block of b
+ * @param width number of entries of the block of b
+ */
+static inline size_t emit_block_matches(unsigned mask, const uint32_t *a, const uint32_t *b, size_t width,
+                                        uint32_t *out_a, uint32_t *out_b) {
+    size_t n = 0;
+    while (mask) {
+        unsigned k = (unsigned) __builtin_ctz(mask);
+        mask &= mask - 1;
+        uint32_t x = a[k] & SortedIntersect::ID_MASK;
+        for (size_t l = 0; l < width; l++) {
+            if ((b[l] & SortedIntersect::ID_MASK) == x) {
+                out_a[n] = a[k];
+                out_b[n] = b[l];
+                n++;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Block-wise all-pairs comparison of 4 entries of a against 4 entries of b, rotating b with shuffles. The block
+ * with the smaller maximum is advanced; the tails are merged by the scalar kernel
+ */
+__attribute__((target("sse4.1")))
+size_t SortedIntersect::intersect_sse4(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                                       uint32_t *out_a, uint32_t *out_b) {
+    const __m128i id_mask = _mm_set1_epi32((int) ID_MASK);
+    size_t i = 0, j = 0, n = 0;
+    while (i + 4 <= na and j + 4 <= nb) {
+        __m128i va = _mm_and_si128(_mm_loadu_si128((const __m128i *) (a + i)), id_mask);
+        __m128i vb = _mm_and_si128(_mm_loadu_si128((const __m128i *) (b + j)), id_mask);
+        __m128i cmp = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, vb));
+        if (!_mm_testz_si128(cmp, cmp)) {
+            unsigned mask = (unsigned) _mm_movemask_ps(_mm_castsi128_ps(cmp));
+            n += emit_block_matches(mask, a + i, b + j, 4, out_a + n, out_b + n);
+        }
+
+        uint32_t a_max = a[i + 3] & ID_MASK;
+        uint32_t b_max = b[j + 3] & ID_MASK;
+        if (a_max <= b_max) i += 4;
+        if (b_max <= a_max) j += 4;
+    }
+    return n + intersect_scalar(a + i, na - i, b + j, nb - j, out_a + n, out_b + n);
+}
+
+/**
+ * Block-wise all-pairs comparison of 8 entries of a against 8 entries of b, rotating b with cross-lane
+ * permutations. The block with the smaller maximum is advanced; the tails are merged by the scalar kernel
+ */
+__attribute__((target("avx2")))
+size_t SortedIntersect::intersect_avx2(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                                       uint32_t *out_a, uint32_t *out_b) {
+    const __m256i id_mask = _mm256_set1_epi32((int) ID_MASK);
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    size_t i = 0, j = 0, n = 0;
+    while (i + 8 <= na and j + 8 <= nb) {
+        __m256i va = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (a + i)), id_mask);
+        __m256i vb = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (b + j)), id_mask);
+        __m256i cmp = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; r++) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            cmp = _mm256_or_si256(cmp, _mm256_cmpeq_epi32(va, vb));
+        }
+        if (!_mm256_testz_si256(cmp, cmp)) {
+            unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+            n += emit_block_matches(mask, a + i, b + j, 8, out_a + n, out_b + n);
+        }
+
+        uint32_t a_max = a[i + 7] & ID_MASK;
+        uint32_t b_max = b[j + 7] & ID_MASK;
+        if (a_max <= b_max) i += 8;
+        if (b_max <= a_max) j += 8;
+    }
+    return n + intersect_scalar(a + i, na - i, b + j, nb - j, out_a + n, out_b + n);
+}
+
+#endif
@@ -10,23 +10,21 @@
  * @param k memory budget
  * @param alpha
  * @param beta
+ * @param local_counting true to also estimate the local triangles of every node; global-only runs skip the per-node
+ * updates and their memory
  */
-Tonic::Tonic(int random_seed, long k, double alpha, double beta) : t_(0), k_(k), alpha_(alpha),
-                                                                   beta_(beta)  {
+Tonic::Tonic(int random_seed, long k, double alpha, double beta, bool local_counting)
+        : rng_((uint64_t) random_seed), t_(0), local_counting_(local_counting), k_(k), alpha_(alpha), beta_(beta) {
 
     printf("Starting Tonic Algo - alpha %.3f, beta = %.3f | Memory Budget = %ld\n", alpha, beta, k);
     WR_size_ = (long) (k_ * alpha);
     H_size_ = (long) ((k_ - WR_size_) * beta);
     SL_size_ = k_ - WR_size_ - H_size_;
     waiting_room_ = new Edge[WR_size_];
-    heavy_edges_ = FixedSizePQ<Heavy_edge, heavy_edge_cmp>(H_size_);
+    heavy_edges_ = IndexedFixedSizePQ<Heavy_edge, heavy_edge_cmp, heavy_edge_key, Utils::hash_edge_id, false>(H_size_);
     light_edges_sample_ = new Edge[SL_size_];
     num_edges_ = 0;
     printf("WR size = %ld, H size = %ld, SL size = %ld\n", WR_size_, H_size_, SL_size_);
-    subgraph_ = emhash5::HashMap<int, emhash5::HashMap<int, bool>>();
-    gen_ = std::mt19937(random_seed);
-    dis_ = std::uniform_real_distribution<double>(0.0, 1.0);
-    dis_int_ = std::uniform_int_distribution<int>(0, (int)SL_size_ - 1);
 }
 
 
@@ -36,24 +34,15 @@ Tonic::Tonic(int random_seed, long k, double alpha, double beta) : t_(0), k_(k),
 Tonic::~Tonic() {
     delete[] waiting_room_;
     delete[] light_edges_sample_;
-    subgraph_.clear();
 }
 
 /**
- * Set the edge oracle for Tonic
- * @param edge_oracle
+ * Set the oracle for Tonic. The oracle is shared, not copied
+ * @param oracle
  */
-void Tonic::set_edge_oracle(emhash5::HashMap<long, int> &edge_oracle) {
-    edge_id_oracle_ = edge_oracle;
-    edge_oracle_flag_ = true;
-}
-
-/**
- * Set the node oracle for Tonic
- * @param node_oracle
- */
-void Tonic::set_node_oracle(emhash5::HashMap<int, int> &node_oracle) {
-    node_oracle_ = node_oracle;
+void Tonic::set_oracle(std::shared_ptr<const Oracle> oracle) {
+    oracle_ = std::move(oracle);
+    edge_oracle_flag_ = oracle_ and oracle_->is_edge_oracle();
 }
 
 /**
@@ -63,23 +52,7 @@ void Tonic::set_node_oracle(emhash5::HashMap<int, int> &node_oracle) {
  * @return heaviness if the edge or both nodes are found in the predictor, -1 otherwise
  */
 int Tonic::get_heaviness(const int u, const int v) {
-    if (edge_oracle_flag_) {
-        auto id_it = edge_id_oracle_.find(edge_to_id(u, v));
-        if (id_it != edge_id_oracle_.end()) {
-            return id_it->second;
-        } else {
-            return -1;
-        }
-    } else {
-        auto u_it = node_oracle_.find(u);
-        if (u_it != node_oracle_.end()) {
-            auto v_it = node_oracle_.find(v);
-            if (v_it != node_oracle_.end()) {
-                return std::min(u_it->second, v_it->second);
-            }
-        }
-        return -1;
-    }
+    return oracle_ ? oracle_->get_heaviness(u, v, oracle_stats_) : -1;
 }
 
 /**
@@ -87,7 +60,23 @@ int Tonic::get_heaviness(const int u, const int v) {
  * @return random double
  */
 inline double Tonic::next_double() {
-    return dis_(gen_);
+    return rng_.next_double();
+}
+
+/**
+ * Advance SL_next_ to the next light edge admitted into the full SL reservoir, drawing the skip length from the
+ * geometric distribution of Algorithm L. The first call, when the reservoir has just filled, initializes W
+ */
+void Tonic::next_SL_skip() {
+    // -- 1 - U lies in (0, 1], avoiding log(0)
+    if (SL_next_ == 0) {
+        SL_w_ = std::exp(std::log(1.0 - next_double()) / (double) SL_size_);
+        SL_next_ = SL_size_;
+    } else {
+        SL_w_ *= std::exp(std::log(1.0 - next_double()) / (double) SL_size_);
+    }
+    double skip = std::floor(std::log(1.0 - next_double()) / std::log(1.0 - SL_w_));
+    SL_next_ += (skip < 1e15 ? (long) skip : (long) 1e15) + 1;
 }
 
 /**
@@ -95,7 +84,7 @@ inline double Tonic::next_double() {
  * @return number of nodes
  */
 int Tonic::get_num_nodes() const {
-    return (int) subgraph_.size();
+    return (int) subgraph_.num_nodes();
 }
 
 /**
@@ -106,15 +95,67 @@ int Tonic::get_num_edges() const {
     return num_edges_;
 }
 
+/**
+ * Choose how light edges are admitted into the full SL reservoir. By default each edge draws a coin with probability
+ * SL_size / SL_cur; with skip sampling (Vitter's Algorithm L) the number of edges to reject before the next admission
+ * is drawn in advance, so rejected edges cost no random draw. Both give each edge the same SL_size / SL_cur admission
+ * probability
+ * @param sl_skip_sampling
+ */
+void Tonic::set_sl_skip_sampling(bool sl_skip_sampling) {
+    sl_skip_sampling_ = sl_skip_sampling;
+}
+
+/**
+ * Make this instance a shard of a colour partition: it is fed only the edges routed to the shard, and counts only the
+ * triangles whose colour triple is the one of the shard
+ * @param colours partition shared by all the shards
+ * @param shard of this instance
+ */
+void Tonic::set_colour_shard(std::shared_ptr<const ColourPartition> colours, int shard) {
+    colours_ = std::move(colours);
+    shard_ = shard;
+}
+
+/**
+ * Set the degree at which a node of the sampled subgraph gets a bitmap neighborhood
+ * @param hub_degree 0 to keep all neighborhoods in the slab
+ */
+void Tonic::set_hub_degree(uint32_t hub_degree) {
+    subgraph_.set_hub_degree(hub_degree);
+}
+
+/**
+ * Set the number of nodes of a stream with node ids in [0, num_nodes), if known: the local counts are then allocated
+ * once, as a flat array of num_nodes entries
+ * @param num_nodes 0 if unknown
+ */
+void Tonic::set_num_nodes(size_t num_nodes) {
+    if (local_counting_) local_triangles_cnt_.reserve(num_nodes);
+}
+
+/**
+ * Return the number of 64-bit random outputs drawn so far
+ * @return random draws
+ */
+size_t Tonic::get_random_draws() const {
+    return rng_.generated();
+}
+
+/**
+ * Return the bytes allocated by the sampled subgraph
+ * @return allocated bytes
+ */
+size_t Tonic::get_subgraph_memory() const {
+    return subgraph_.memory_bytes();
+}
+
 /**
  * Return the nodes in the subgraph
  * @param nodes to fill
  */
 void Tonic::get_nodes(std::vector<int> &nodes) const {
-    nodes.clear();
-    for (const auto &it: subgraph_) {
-        nodes.push_back(it.first);
-    }
+    subgraph_.get_nodes(nodes);
 }
 
 /**
@@ -122,10 +163,16 @@ void Tonic::get_nodes(std::vector<int> &nodes) const {
  * @param nodes to fill
  */
 void Tonic::get_local_nodes(std::vector<int> &nodes) const {
-    nodes.clear();
-    for (const auto &it: local_triangles_cnt_) {
-        nodes.push_back(it.first);
-    }
+    local_triangles_cnt_.get_nodes(nodes);
+}
+
+/**
+ * Return the n nodes with the largest local triangle counts, by decreasing count
+ * @param n 0 for all the nodes with a positive count
+ * @param top_nodes to fill with (node, count) pairs
+ */
+void Tonic::get_top_local_triangles(size_t n, std::vector<std::pair<int, double>> &top_nodes) const {
+    local_triangles_cnt_.top(n, top_nodes);
 }
 
 /**
@@ -136,8 +183,7 @@ void Tonic::get_local_nodes(std::vector<int> &nodes) const {
  */
 void Tonic::add_edge(const int u, const int v, bool det) {
     num_edges_++;
-    subgraph_[u].emplace_unique(v, det);
-    subgraph_[v].emplace_unique(u, det);
+    subgraph_.add_edge(u, v, det);
 
 }
 
@@ -148,16 +194,7 @@ void Tonic::add_edge(const int u, const int v, bool det) {
  */
 void Tonic::remove_edge(const int u, const int v) {
     num_edges_--;
-    subgraph_[u].erase(v);
-    subgraph_[v].erase(u);
-}
-
-/**
- * Function that return the current timestamp in the stream
- * @return current timestamp
- */
-inline unsigned long long Tonic::get_edges_processed() const {
-    return t_;
+    subgraph_.remove_edge(u, v);
 }
 
 /**
@@ -174,90 +211,61 @@ double Tonic::get_global_triangles() const {
  * @return the local triangle count for node u
  */
 double Tonic::get_local_triangles(const int u) const {
-    auto u_it = local_triangles_cnt_.find(u);
-    if (u_it != local_triangles_cnt_.end()) {
-        return u_it->second;
-    } else {
-        return 0.0;
-    }
+    return local_triangles_cnt_.get(u);
 }
 
 /**
  * Function that counts the triangles closed by the current edge (src, dst). The function is called before the edge is
- * sampled.
+ * sampled. Without local counting or colour shards, the common neighbors are only counted by number of light edges
+ * in their wedge, without visiting them one by one.
  * @param src
  * @param dst
  */
-void Tonic::count_triangles(const int src, const int dst) {
-    emhash5::HashMap<int, bool> *u_neighs, *v_neighs;
-    auto u_it = subgraph_.find(src);
-    if (u_it == subgraph_.end()) {
-        return;
-    }
-    u_neighs = &u_it->second;
-    int du = (int) u_neighs->size();
-
-    auto v_it = subgraph_.find(dst);
-    if (v_it == subgraph_.end()) {
+void Tonic::count_triangles(const int u, const int v) {
+
+    if (!local_counting_ and !colours_) {
+        size_t counts[3] = {0, 0, 0};
+        subgraph_.count_common_neighbors(u, v, counts);
+        double cum_cnt = (double) (counts[0] + counts[1] + counts[2]);
+        if (SL_cur_ > SL_size_) {
+            // -- one light edge, then both light edges
+            cum_cnt = (double) counts[0];
+            cum_cnt += (double) counts[1] * ((double) (SL_cur_) / SL_size_);
+            cum_cnt += (double) counts[2] * ((double) (SL_cur_) / SL_size_) * ((double) ((SL_cur_ - 1.0))) /
+                       (SL_size_ - 1.0);
+        }
+        global_triangles_cnt_ += cum_cnt;
         return;
     }
-    v_neighs = &v_it->second;
-    int dv = (int) v_neighs->size();
-    int u = src;
-    int v = dst;
-
-    if (du > dv) {
-        v = src;
-        u = dst;
-        emhash5::HashMap<int, bool> *u_neighs_tmp = u_neighs;
-        u_neighs = v_neighs;
-        v_neighs = u_neighs_tmp;
-    }
 
     double cum_cnt = 0.0;
-
-    // -- iterate over the neighbors of u
-    for (const auto &it: *u_neighs) {
-        int w = it.first;
-        auto vw_it = v_neighs->find(w);
-        if (vw_it != v_neighs->end()) {
-            // -- triangle {u, v, w} discovered
-            double increment_T = 1.0;
-            if (SL_cur_ > SL_size_) {
-                bool vw_light = !vw_it->second;
-                bool wu_light = !it.second;
-                if (vw_light && wu_light) {
-                    increment_T = ((double) (SL_cur_) / SL_size_) * ((double) ((SL_cur_ - 1.0))) / (SL_size_ - 1.0);
-                } else if (vw_light || wu_light) {
-                    increment_T = ((double) (SL_cur_) / SL_size_);
-                }
+    int w_colour = colours_ ? colours_->missing_colour(shard_, colours_->colour(u), colours_->colour(v)) : -1;
+
+    // -- iterate over the common neighbors of u and v
+    subgraph_.for_each_common_neighbor(u, v, [&](int w, bool uw_det, bool vw_det) {
+        // -- triangle {u, v, w} discovered, counted by another shard if w has not the colour completing the triple
+        if (colours_ and colours_->colour(w) != w_colour) return;
+        double increment_T = 1.0;
+        if (SL_cur_ > SL_size_) {
+            bool vw_light = !vw_det;
+            bool wu_light = !uw_det;
+            if (vw_light && wu_light) {
+                increment_T = ((double) (SL_cur_) / SL_size_) * ((double) ((SL_cur_ - 1.0))) / (SL_size_ - 1.0);
+            } else if (vw_light || wu_light) {
+                increment_T = ((double) (SL_cur_) / SL_size_);
             }
-
-            cum_cnt += increment_T;
-            auto w_it = local_triangles_cnt_.find(w);
-            if (w_it != local_triangles_cnt_.end()) {
-                w_it->second += increment_T;
-            } else {
-                local_triangles_cnt_.insert_unique(w, increment_T);
-            }
-
         }
-    } // end for
+
+        cum_cnt += increment_T;
+        if (local_counting_) local_triangles_cnt_.add(w, increment_T);
+    });
 
     // -- update counters
     if (cum_cnt > 0) {
         global_triangles_cnt_ += cum_cnt;
-        auto u_local_it = local_triangles_cnt_.find(u);
-        if (u_local_it != local_triangles_cnt_.end()) {
-            u_local_it->second += cum_cnt;
-        } else {
-            local_triangles_cnt_.insert_unique(u, cum_cnt);
-        }
-        auto v_local_it = local_triangles_cnt_.find(v);
-        if (v_local_it != local_triangles_cnt_.end()) {
-            v_local_it->second += cum_cnt;
-        } else {
-            local_triangles_cnt_.insert_unique(v, cum_cnt);
+        if (local_counting_) {
+            local_triangles_cnt_.add(u, cum_cnt);
+            local_triangles_cnt_.add(v, cum_cnt);
         }
     }
 }
@@ -295,11 +303,9 @@ bool Tonic::sample_edge(const int src, const int dst) {
                 if (current_heaviness > lightest_heaviness ||
                     (current_heaviness == lightest_heaviness && next_double() < 0.5)) {
                     // -- replace the lightest heavy edge with current edge
-                    heavy_edges_.pop();
-                    heavy_edges_.push({{u, v}, current_heaviness});
+                    heavy_edges_.replace_top({{u, v}, current_heaviness});
                     is_det = true;
-                    subgraph_[lightest_heavy_edge.first.first][lightest_heavy_edge.first.second] = false;
-                    subgraph_[lightest_heavy_edge.first.second][lightest_heavy_edge.first.first] = false;
+                    subgraph_.add_edge(lightest_heavy_edge.first.first, lightest_heavy_edge.first.second, false);
                     uv_sample = lightest_heavy_edge.first;
                 }
             }
@@ -326,24 +332,30 @@ bool Tonic::sample_edge(const int src, const int dst) {
                 if (current_heaviness > lightest_heaviness ||
                     (current_heaviness == lightest_heaviness && next_double() < 0.5)) {
                     // -- replace the lightest heavy edge with current edge
-                    heavy_edges_.pop();
-                    heavy_edges_.push({{u, v}, current_heaviness});
-                    subgraph_[lightest_heavy_edge.first.first][lightest_heavy_edge.first.second] = false;
-                    subgraph_[lightest_heavy_edge.first.second][lightest_heavy_edge.first.first] = false;
+                    heavy_edges_.replace_top({oldest_edge, current_heaviness});
+                    subgraph_.add_edge(lightest_heavy_edge.first.first, lightest_heavy_edge.first.second, false);
                     uv_sample = lightest_heavy_edge.first;
                 }
             }
 
-            double p = (double) (SL_size_) / (double) SL_cur_;
-            if (next_double() < p) {
+            bool sampled;
+            if (sl_skip_sampling_) {
+                // -- sampled only at the precomputed positions: rejected edges draw no random number
+                if (SL_next_ == 0 and SL_size_ > 0) next_SL_skip();
+                sampled = SL_size_ > 0 and SL_cur_ == SL_next_;
+            } else {
+                double p = (double) (SL_size_) / (double) SL_cur_;
+                sampled = next_double() < p;
+            }
+            if (sampled) {
                 // -- edge is sampled
-                subgraph_[uv_sample.first][uv_sample.second] = false;
-                subgraph_[uv_sample.second][uv_sample.first] = false;
+                subgraph_.add_edge(uv_sample.first, uv_sample.second, false);
                 // -- evict edge uniformly at random
-                int replace_idx = (int) (rand() % SL_size_);
+                int replace_idx = (int) rng_.next_index(SL_size_);
                 Edge uv_replace = light_edges_sample_[replace_idx];
                 remove_edge(uv_replace.first, uv_replace.second);
                 light_edges_sample_[replace_idx] = uv_sample;
+                if (sl_skip_sampling_) next_SL_skip();
             } else {
                 // -- edge is not resampled, just remove it from subgraph
                 remove_edge(uv_sample.first, uv_sample.second);
@@ -362,9 +374,28 @@ bool Tonic::sample_edge(const int src, const int dst) {
  * @param dst
  */
 void Tonic::process_edge(const int u, const int v) {
+    // -- edges the subgraph cannot store are not part of the stream
+    if (!SampledGraph::valid_id(u) or !SampledGraph::valid_id(v)) return;
     count_triangles(u, v);
     bool is_det = sample_edge(u, v);
     add_edge(u, v, is_det);
     t_++;
     assert(heavy_edges_.size() <= H_size_);
 }
+
+/**
+ * Process a batch of edges in stream order, as process_edge on each of them. Prefetches are issued in two stages, so
+ * that the cache misses of the upcoming edges overlap with the work on the current ones: the directory slots of the
+ * endpoints and the oracle slot of the edge 2 * PREFETCH_DISTANCE ahead, then the neighbors of the endpoints of the
+ * edge PREFETCH_DISTANCE ahead, whose directory slots are cached by then. Prefetching has no effect on the estimates
+ * @param edges
+ */
+void Tonic::process_edges(std::span<const StreamEdge> edges) {
+    size_t n = edges.size();
+    for (size_t i = 0; i < std::min(2 * PREFETCH_DISTANCE, n); i++) prefetch_edge(edges[i]);
+    for (size_t i = 0; i < n; i++) {
+        if (i + 2 * PREFETCH_DISTANCE < n) prefetch_edge(edges[i + 2 * PREFETCH_DISTANCE]);
+        if (i + PREFETCH_DISTANCE < n) prefetch_neighbors(edges[i + PREFETCH_DISTANCE]);
+        process_edge(edges[i].u, edges[i].v);
+    }
+}
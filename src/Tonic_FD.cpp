@@ -8,53 +8,87 @@
  * Constructor for the WaitingRoom class used in Tonic_FD
  * @param max_size corresponding to k(alpha) in the paper
  */
-Tonic_FD::WaitingRoom::WaitingRoom(long max_size) : max_size_(max_size), cur_size_(0), oldest_edge_idx_(0) {
-    waiting_room_ = emhash8::HashSet<unsigned long long>(max_size);
+Tonic_FD::WaitingRoom::WaitingRoom(long max_size) : next_edge_idx_(0), max_size_(max_size), cur_size_(0),
+                                                      oldest_edge_idx_(0) {
+    unsigned long long capacity = 2;
+    while (capacity < 2 * (unsigned long long) max_size) capacity <<= 1;
+    waiting_room_ = new Edge[capacity];
+    capacity_mask_ = capacity - 1;
+    edge_to_slot_ = emhash5::HashMap<unsigned long long, unsigned long long, Utils::hash_edge_id>(max_size);
 }
 
 /**
  * Destructor for the WaitingRoom class
  */
-Tonic_FD::WaitingRoom::~WaitingRoom() { waiting_room_.clear();}
+Tonic_FD::WaitingRoom::~WaitingRoom() { delete[] waiting_room_; }
 
 /**
- * Convert an edge (u, v) to a unique id and insert the id into the waiting room. If the maximum size is not reached,
- * increment the current size.
+ * Move the edges of the waiting room next to each other, in the same order, dropping the tombstones
+ */
+void Tonic_FD::WaitingRoom::compact() {
+    unsigned long long w = oldest_edge_idx_;
+    for (unsigned long long r = oldest_edge_idx_; r < next_edge_idx_; r++) {
+        Edge edge = waiting_room_[r & capacity_mask_];
+        if (edge.first == TOMBSTONE) continue;
+        waiting_room_[w & capacity_mask_] = edge;
+        edge_to_slot_[edge_to_wr_id(edge.first, edge.second)] = w & capacity_mask_;
+        w++;
+    }
+    next_edge_idx_ = w;
+}
+
+/**
+ * Insert an edge (u, v) as the newest edge of the waiting room and increment the current size. An edge already in
+ * the waiting room is left in place.
  * @param u
  * @param v
  */
 void Tonic_FD::WaitingRoom::add_edge(int u, int v) {
 
-    unsigned long long edge_id = (long) edge_to_wr_id(u, v);
-    waiting_room_.emplace_unique(edge_id);
+    unsigned long long edge_id = edge_to_wr_id(u, v);
+    if (edge_to_slot_.find(edge_id) != edge_to_slot_.end()) {
+        return;
+    }
 
-    if (cur_size_ < max_size_) {
-        cur_size_++;
+    if (next_edge_idx_ - oldest_edge_idx_ > capacity_mask_) {
+        compact();
     }
+    unsigned long long slot = next_edge_idx_ & capacity_mask_;
+    waiting_room_[slot] = {u, v};
+    edge_to_slot_.insert_unique(edge_id, slot);
+    next_edge_idx_++;
+    cur_size_++;
 
 }
 
 /**
- * Pop the oldest edge from the waiting room, converts the id back to the edge, and return it
+ * Pop the oldest edge from the waiting room, skipping the tombstones of deleted edges, and return it. The waiting
+ * room must not be empty
  * @return the popped oldest edge
  */
 Utils::Edge Tonic_FD::WaitingRoom::pop_oldest_edge() {
-    unsigned long long oldest_edge_id = *waiting_room_.begin();
-    waiting_room_.erase(oldest_edge_id);
-    return edge_wr_to_id(oldest_edge_id);
+    while (waiting_room_[oldest_edge_idx_ & capacity_mask_].first == TOMBSTONE) {
+        oldest_edge_idx_++;
+    }
+    Edge oldest_edge = waiting_room_[oldest_edge_idx_ & capacity_mask_];
+    oldest_edge_idx_++;
+    edge_to_slot_.erase(edge_to_wr_id(oldest_edge.first, oldest_edge.second));
+    cur_size_--;
+    return oldest_edge;
 }
 
 /**
- * Remove an edge (u, v) from the waiting room, used in the case of edge deletions
+ * Remove an edge (u, v) from the waiting room, used in the case of edge deletions. Its slot becomes a tombstone
  * @param u
  * @param v
  * @return true if the edge was found and removed, false otherwise
  */
 bool Tonic_FD::WaitingRoom::remove_edge(int u, int v) {
 
-    unsigned long long edge_id = (long) edge_to_wr_id(u, v);
-    if (waiting_room_.find(edge_id) != waiting_room_.end()) {
-        waiting_room_.erase(edge_id);
+    auto slot_it = edge_to_slot_.find(edge_to_wr_id(u, v));
+    if (slot_it != edge_to_slot_.end()) {
+        waiting_room_[slot_it->second] = {TOMBSTONE, TOMBSTONE};
+        edge_to_slot_.erase(slot_it);
         cur_size_ --;
         return true;
     }
@@ -70,9 +104,12 @@ bool Tonic_FD::WaitingRoom::remove_edge(int u, int v) {
  * @param k memory budget
  * @param alpha
  * @param beta
+ * @param local_counting true to also estimate the local triangles of every node; global-only runs only count the
+ * common neighbors of each edge by class, without visiting them one by one
  */
-Tonic_FD::Tonic_FD(int random_seed, long k, double alpha, double beta) : t_(0), k_(k), alpha_(alpha),
-                                                                                       beta_(beta) {
+Tonic_FD::Tonic_FD(int random_seed, long k, double alpha, double beta, bool local_counting)
+        : subgraph_(k), rng_((uint64_t) random_seed), t_(0), local_counting_(local_counting), k_(k), alpha_(alpha),
+          beta_(beta) {
 
     printf("Starting Tonic Algo - alpha %.3f, beta = %.3f | Memory Budget = %ld || Random Seed = %d\n",
            alpha, beta, k, random_seed);
@@ -80,15 +117,11 @@ Tonic_FD::Tonic_FD(int random_seed, long k, double alpha, double beta) : t_(0),
     H_size_ = (long) ((k_ - WR_size_) * beta);
     SL_size_ = k_ - WR_size_ - H_size_;
     waiting_room_ = new WaitingRoom(WR_size_);
-    heavy_edges_ = FixedSizePQ<Heavy_edge, heavy_edge_cmp>(H_size_);
-    heavy_edges_set_ = emhash8::HashSet<unsigned long long>(H_size_);
+    heavy_edges_ = IndexedFixedSizePQ<Heavy_edge, heavy_edge_cmp, heavy_edge_key, Utils::hash_edge_id>(H_size_);
     light_edges_sample_ = new Edge[SL_size_];
     num_edges_ = 0;
     printf("WR size = %ld, H size = %ld, SL size = %ld\n", WR_size_, H_size_, SL_size_);
-    subgraph_ = emhash5::HashMap<int, emhash5::HashMap<int, bool>>(k);
-    gen_ = std::mt19937(random_seed);
-    dis_ = std::uniform_real_distribution<double>(0.0, 1.0);
-    edge_id_to_index_ = emhash5::HashMap<long, int>(SL_size_);
+    edge_id_to_index_ = emhash5::HashMap<long, int, Utils::hash_edge_id>(SL_size_);
 
 }
 
@@ -101,20 +134,12 @@ Tonic_FD::~Tonic_FD() {
 }
 
 /**
- * Set the edge oracle for the Tonic_FD class
- * @param edge_oracle
- */
-void Tonic_FD::set_edge_oracle(emhash5::HashMap<long, int> &edge_oracle) {
-    edge_id_oracle_ = edge_oracle;
-    edge_oracle_flag_ = true;
-}
-
-/**
- * Set the node oracle for the Tonic_FD class
- * @param node_oracle
+ * Set the oracle for Tonic_FD. The oracle is shared, not copied
+ * @param oracle
  */
-void Tonic_FD::set_node_oracle(emhash5::HashMap<int, int> &node_oracle) {
-    node_oracle_ = node_oracle;
+void Tonic_FD::set_oracle(std::shared_ptr<const Oracle> oracle) {
+    oracle_ = std::move(oracle);
+    edge_oracle_flag_ = oracle_ and oracle_->is_edge_oracle();
 }
 
 /**
@@ -124,24 +149,7 @@ void Tonic_FD::set_node_oracle(emhash5::HashMap<int, int> &node_oracle) {
  * @return heaviness if the edge or both nodes are found in the predictor, -1 otherwise
  */
 int Tonic_FD::get_heaviness(const int u, const int v) {
-    if (edge_oracle_flag_) {
-        auto id_it = edge_id_oracle_.find(edge_to_id(u, v));
-        if (id_it != edge_id_oracle_.end()) {
-            return id_it->second;
-        } else {
-            return -1;
-        }
-    } else {
-        // -- print node u
-        auto u_it = node_oracle_.find(u);
-        if (u_it != node_oracle_.end()) {
-            auto v_it = node_oracle_.find(v);
-            if (v_it != node_oracle_.end()) {
-                return std::min(u_it->second, v_it->second);
-            }
-        }
-        return -1;
-    }
+    return oracle_ ? oracle_->get_heaviness(u, v, oracle_stats_) : -1;
 }
 
 /**
@@ -149,7 +157,7 @@ int Tonic_FD::get_heaviness(const int u, const int v) {
  * @return random double
  */
 inline double Tonic_FD::next_double() {
-    return dis_(gen_);
+    return rng_.next_double();
 }
 
 /**
@@ -157,7 +165,7 @@ inline double Tonic_FD::next_double() {
  * @return number of nodes
  */
 long Tonic_FD::get_num_nodes() const {
-    return (long) subgraph_.size();
+    return (long) subgraph_.num_nodes();
 }
 
 /**
@@ -168,15 +176,45 @@ long Tonic_FD::get_num_edges() const {
     return num_edges_;
 }
 
+/**
+ * Set the degree at which a node of the sampled subgraph gets a bitmap neighborhood
+ * @param hub_degree 0 to keep all neighborhoods in the slab
+ */
+void Tonic_FD::set_hub_degree(uint32_t hub_degree) {
+    subgraph_.set_hub_degree(hub_degree);
+}
+
+/**
+ * Set the number of nodes of a stream with node ids in [0, num_nodes), if known: the local counts are then allocated
+ * once, as a flat array of num_nodes entries
+ * @param num_nodes 0 if unknown
+ */
+void Tonic_FD::set_num_nodes(size_t num_nodes) {
+    if (local_counting_) local_triangles_cnt_.reserve(num_nodes);
+}
+
+/**
+ * Return the number of 64-bit random outputs drawn so far
+ * @return random draws
+ */
+size_t Tonic_FD::get_random_draws() const {
+    return rng_.generated();
+}
+
+/**
+ * Return the bytes allocated by the sampled subgraph
+ * @return allocated bytes
+ */
+size_t Tonic_FD::get_subgraph_memory() const {
+    return subgraph_.memory_bytes();
+}
+
 /**
  * Return the nodes in the subgraph
  * @param nodes to fill
  */
 void Tonic_FD::get_nodes(std::vector<int> &nodes) const {
-    nodes.clear();
-    for (const auto &it: subgraph_) {
-        nodes.push_back(it.first);
-    }
+    subgraph_.get_nodes(nodes);
 }
 
 /**
@@ -184,10 +222,17 @@ void Tonic_FD::get_nodes(std::vector<int> &nodes) const {
  * @param nodes to fill
  */
 void Tonic_FD::get_local_nodes(std::vector<int> &nodes) const {
-    nodes.clear();
-    for (const auto &it: local_triangles_cnt_) {
-        nodes.push_back(it.first);
-    }
+    local_triangles_cnt_.get_nodes(nodes);
+}
+
+/**
+ * Return the n nodes with the largest local triangle counts, by decreasing count. Nodes with a count not greater than
+ * 0 are never returned
+ * @param n 0 for all the nodes with a positive count
+ * @param top_nodes to fill with (node, count) pairs
+ */
+void Tonic_FD::get_top_local_triangles(size_t n, std::vector<std::pair<int, double>> &top_nodes) const {
+    local_triangles_cnt_.top(n, top_nodes);
 }
 
 /**
@@ -198,8 +243,7 @@ void Tonic_FD::get_local_nodes(std::vector<int> &nodes) const {
  */
 void Tonic_FD::add_edge(const int u, const int v, bool det) {
 
-    subgraph_[u][v] = det;
-    subgraph_[v][u] = det;
+    subgraph_.add_edge(u, v, det);
     num_edges_++;
 
 }
@@ -212,34 +256,11 @@ void Tonic_FD::add_edge(const int u, const int v, bool det) {
  * 1 if the deleted edge is det (W or H). If present, remove directly the edge from the subgraph
  */
 int Tonic_FD::edge_deletion(const int u, const int v) {
-    auto u_it = subgraph_.find(u);
-    if (u_it != subgraph_.end()) {
-        if (u_it->second.find(v) != u_it->second.end()) {
-            // -- edge uv found
-            bool u_det = u_it->second[v];
-            num_edges_--;
-            u_it->second.erase(v);
-            if (u_it->second.empty()) {
-                subgraph_.erase(u);
-            }
-
-            auto v_it = subgraph_.find(v);
-            if (v_it != subgraph_.end()) {
-                if (v_it->second.find(u) != v_it->second.end()) {
-                    // -- edge vu found
-                    bool v_det = v_it->second[u];
-                    v_it->second.erase(u);
-                    if (v_it->second.empty()) {
-                        subgraph_.erase(v);
-                    }
-
-                    // -- return 1 if edge is det, 0 if edge is not det
-                    assert(u_det == v_det);
-                    return (u_det ? 1 : 0);
-
-                }
-            }
-        }
+    bool det;
+    if (subgraph_.remove_edge(u, v, det)) {
+        // -- edge uv found: return 1 if edge is det, 0 if edge is not det
+        num_edges_--;
+        return (det ? 1 : 0);
     }
 
     // -- return -1: edge not found
@@ -253,44 +274,14 @@ int Tonic_FD::edge_deletion(const int u, const int v) {
  * @return true if the edge was found and removed, false otherwise
  */
 bool Tonic_FD::remove_edge(const int u, const int v) {
-    auto u_it = subgraph_.find(u);
-    if (u_it != subgraph_.end()) {
-        if (u_it->second.find(v) != u_it->second.end()) {
-            // -- edge uv found
-            num_edges_--;
-            u_it->second.erase(v);
-            if (u_it->second.empty()) {
-                subgraph_.erase(u);
-            }
-
-            auto v_it = subgraph_.find(v);
-            if (v_it != subgraph_.end()) {
-                if (v_it->second.find(u) != v_it->second.end()) {
-                    // -- edge vu found
-                    v_it->second.erase(u);
-                    if (v_it->second.empty()) {
-                        subgraph_.erase(v);
-                    }
-
-                    return true;
-
-                }
-            }
-        }
-
+    if (subgraph_.remove_edge(u, v)) {
+        num_edges_--;
+        return true;
     }
 
     return false;
 }
 
-/**
- * Function that return the current timestamp in the stream
- * @return current timestamp
- */
-inline unsigned long long Tonic_FD::get_edges_processed() const {
-    return t_;
-}
-
 /**
  * Function that returns the global triangle count
  * @return the global triangle count (0 if negatives)
@@ -306,83 +297,52 @@ double Tonic_FD::get_global_triangles() const {
  * @return the local triangle count for node u (0 if negative)
  */
 double Tonic_FD::get_local_triangles(const int u) const {
-    auto u_it = local_triangles_cnt_.find(u);
-    if (u_it != local_triangles_cnt_.end()) {
-        return std::max(0.0, u_it->second);
-    } else {
-        return 0.0;
-    }
+    return std::max(0.0, local_triangles_cnt_.get(u));
 }
 
 /**
  * Function that counts the triangles closed by the current edge (src, dst). Increments the counters if sign is +,
- * or decrements the counters if sign is -. The function is called before the edge is sampled.
+ * or decrements the counters if sign is -. The function is called before the edge is sampled. With local counting,
+ * each common neighbor w gets the weight of its own triangle, and u and v the sum of the weights.
  * @param src
  * @param dst
  * @param sign
  */
-void Tonic_FD::count_triangles(const int src, const int dst, const int sign) {
-
-    emhash5::HashMap<int, bool> *u_neighs, *v_neighs;
-    auto u_it = subgraph_.find(src);
-    if (u_it == subgraph_.end() or u_it->second.empty()) {
-        return;
-    }
-    u_neighs = &u_it->second;
-    int du = (int) u_neighs->size();
-
-    auto v_it = subgraph_.find(dst);
-    if (v_it == subgraph_.end() or v_it->second.empty()) {
-        return;
-    }
-    v_neighs = &v_it->second;
-
-    int dv = (int) v_neighs->size();
-    int u = src;
-    int v = dst;
-
-    if (du == 0 or dv == 0) {
-        return;
-    }
+void Tonic_FD::count_triangles(const int u, const int v, const int sign) {
 
-    if (du > dv) {
-        v = src;
-        u = dst;
-        emhash5::HashMap<int, bool> *u_neighs_tmp = u_neighs;
-        u_neighs = v_neighs;
-        v_neighs = u_neighs_tmp;
-    }
-
-    double cum_cnt = 0.0;
-
-    for (const auto &it: *u_neighs) {
-        int w = it.first;
-
-        if (w == v) {
-            continue;
+    // -- count the common neighbors of u and v by number of light edges in the wedge: {u, v} itself is never a
+    // -- wedge unless u or v has a self-loop, in which case the wedges through it are skipped below
+    size_t counts[3] = {0, 0, 0};
+    if (!local_counting_ and subgraph_.edge_status(u, u) < 0 and subgraph_.edge_status(v, v) < 0) {
+        subgraph_.count_common_neighbors(u, v, counts);
+    } else {
+        // -- signed weight of a triangle by number of light edges in its wedge, for the local counts
+        double weights[3] = {1.0, 1.0, 1.0};
+        if ((ell_ + d_g + d_b) > SL_size_) {
+            weights[1] = (double) (ell_ + d_g + d_b) / (double) SL_size_;
+            weights[2] = weights[1] * ((double) (ell_ + d_g + d_b - 1.0)) / (SL_size_ - 1.0);
         }
-
-        auto vw_it = v_neighs->find(w);
-        if (vw_it != v_neighs->end()) {
-            // -- triangle {u, v, w} discovered
-            double increment_T = 1.0;
-            if ((ell_ + d_g + d_b) > SL_size_) {
-                bool vw_light = !vw_it->second;
-                bool wu_light = !it.second;
-                if (vw_light && wu_light) {
-                    // -- both edges are light
-                    increment_T =
-                            ((double) (ell_ + d_g + d_b) / SL_size_) * ((double) ((ell_ + d_g + d_b - 1.0))) /
-                            (SL_size_ - 1.0);
-                } else if (vw_light || wu_light) {
-                    // -- one edge is light
-                    increment_T = ((double) (ell_ + d_g + d_b) / (double) SL_size_);
-                }
+        for (double &weight: weights) weight *= sign < 0 ? -1.0 : 1.0;
+        subgraph_.for_each_common_neighbor(u, v, [&](int w, bool uw_det, bool vw_det) {
+            if (w == v or w == u) {
+                return;
             }
+            int light = (uw_det ? 0 : 1) + (vw_det ? 0 : 1);
+            counts[light]++;
+            if (local_counting_) local_triangles_cnt_.add(w, weights[light]);
+        });
+    }
 
-            cum_cnt += increment_T;
-
-        }
+    // -- triangles {u, v, w} discovered
+    double cum_cnt = (double) counts[0];
+    if ((ell_ + d_g + d_b) > SL_size_) {
+        // -- both edges are light
+        cum_cnt += (double) counts[2] * ((double) (ell_ + d_g + d_b) / SL_size_) *
+                   ((double) ((ell_ + d_g + d_b - 1.0))) / (SL_size_ - 1.0);
+        // -- one edge is light
+        cum_cnt += (double) counts[1] * ((double) (ell_ + d_g + d_b) / (double) SL_size_);
+    } else {
+        cum_cnt += (double) (counts[1] + counts[2]);
     }
 
     // -- update counters
@@ -392,8 +352,10 @@ void Tonic_FD::count_triangles(const int src, const int dst, const int sign) {
             cum_cnt = -cum_cnt;
         }
         global_triangles_cnt_ += cum_cnt;
-
-
+        if (local_counting_) {
+            local_triangles_cnt_.add(u, cum_cnt);
+            local_triangles_cnt_.add(v, cum_cnt);
+        }
     }
 
 }
@@ -410,7 +372,6 @@ void Tonic_FD::sample_edge(const int u, const int v) {
         H_cur_++;
         int current_heaviness = get_heaviness(u, v);
         heavy_edges_.push({{u, v}, current_heaviness});
-        heavy_edges_set_.insert(edge_to_id(u, v));
         return;
 
     } else if (waiting_room_->cur_size_ < WR_size_) {
@@ -438,30 +399,14 @@ void Tonic_FD::sample_edge(const int u, const int v) {
 
         if (current_heaviness > -1) {
 
+            // -- deleted heavy edges are erased from the heap, so the top is always in H
             lightest_heavy_edge = heavy_edges_.top();
             lightest_heaviness = lightest_heavy_edge.second;
-            bool found_in_H = heavy_edges_set_.find(
-                    edge_to_id(lightest_heavy_edge.first.first, lightest_heavy_edge.first.second)) !=
-                              heavy_edges_set_.end();
-
-            while (!found_in_H) {
-                heavy_edges_.pop();
-                lightest_heavy_edge = heavy_edges_.top();
-                lightest_heaviness = lightest_heavy_edge.second;
-                found_in_H = heavy_edges_set_.find(
-                        edge_to_id(lightest_heavy_edge.first.first, lightest_heavy_edge.first.second)) !=
-                             heavy_edges_set_.end();
-            }
 
             if (current_heaviness > lightest_heaviness ||
                 (current_heaviness == lightest_heaviness && next_double() < 0.5)) {
                 // -- replace the lightest heavy edge with current edge
-                heavy_edges_.pop();
-                heavy_edges_set_.erase(edge_to_id(lightest_heavy_edge.first.first, lightest_heavy_edge.first.second));
-
-                heavy_edges_.push({{uv_sample.first, uv_sample.second}, current_heaviness});
-                heavy_edges_set_.insert(edge_to_id(uv_sample.first, uv_sample.second));
-
+                heavy_edges_.replace_top({{uv_sample.first, uv_sample.second}, current_heaviness});
                 uv_sample = lightest_heavy_edge.first;
 
             }
@@ -476,23 +421,19 @@ void Tonic_FD::sample_edge(const int u, const int v) {
                 // assert(edge_id_to_index_.size() <= SL_size_);
                 light_edges_sample_[SL_cur_++] = uv_sample;
                 // -- change the edge in the subgraph
-                subgraph_[uv_sample.first][uv_sample.second] = false;
-                subgraph_[uv_sample.second][uv_sample.first] = false;
+                subgraph_.add_edge(uv_sample.first, uv_sample.second, false);
                 return;
 
             } else {
                 // -- all sets are full -> resort to sampling
                 double p = (double) (SL_size_) / (double) ell_;
                 // assert(uv_sample.first < uv_sample.second);
-                if (dis_(gen_) < p) {
+                if (next_double() < p) {
                     // -- edge is sampled
-                    subgraph_[uv_sample.first][uv_sample.second] = false;
-                    subgraph_[uv_sample.second][uv_sample.first] = false;
+                    subgraph_.add_edge(uv_sample.first, uv_sample.second, false);
                     // -- evict edge uniformly at random
                     // assert(SL_cur_ == SL_size_);
-                    std::uniform_int_distribution<int> dis_int = std::uniform_int_distribution<int>(0,
-                                                                                                    (int) SL_cur_ - 1);
-                    int replace_idx = dis_int(gen_);
+                    int replace_idx = (int) rng_.next_index(SL_cur_);
                     Edge uv_replace = light_edges_sample_[replace_idx];
 
                     if (!remove_edge(uv_replace.first, uv_replace.second)) {
@@ -527,8 +468,7 @@ void Tonic_FD::sample_edge(const int u, const int v) {
                 edge_id_to_index_.emplace(edge_to_id(uv_sample.first, uv_sample.second), SL_cur_);
                 light_edges_sample_[SL_cur_++] = uv_sample;
                 // -- change the edge in the subgraph
-                subgraph_[uv_sample.first][uv_sample.second] = false;
-                subgraph_[uv_sample.second][uv_sample.first] = false;
+                subgraph_.add_edge(uv_sample.first, uv_sample.second, false);
                 d_b--;
             } else {
                 remove_edge(uv_sample.first, uv_sample.second);
@@ -559,8 +499,9 @@ void Tonic_FD::process_edge(const int src, const int dst, const int t, const int
         u = dst;
         v = src;
     }
+    // -- events on edges the subgraph cannot store are not part of the stream
+    if (!SampledGraph::valid_id(u) or !SampledGraph::valid_id(v)) return;
 
-    // assert(u < Utils::MAX_ID_NODE and v < Utils::MAX_ID_NODE);
     current_timestamp_ = t;
     t_++;
 
@@ -593,7 +534,7 @@ void Tonic_FD::process_edge(const int src, const int dst, const int t, const int
                 bool is_in_WR = waiting_room_->remove_edge(u, v);
 
                 if (!is_in_WR) {
-                    heavy_edges_set_.erase(edge_to_id(u, v));
+                    heavy_edges_.erase(edge_to_id(u, v));
                     H_cur_--;
                 }
 
@@ -618,4 +559,21 @@ void Tonic_FD::process_edge(const int src, const int dst, const int t, const int
 
 }
 
+/**
+ * Process a batch of events in stream order, as process_edge on each of them. Prefetches are issued in two stages as
+ * in Tonic::process_edges: the directory slots of the endpoints (and the oracle slot, for insertions) of the event
+ * 2 * PREFETCH_DISTANCE ahead, then the neighbors of the endpoints of the event PREFETCH_DISTANCE ahead. Prefetching
+ * has no effect on the estimates
+ * @param edges
+ */
+void Tonic_FD::process_edges(std::span<const StreamEdge> edges) {
+    size_t n = edges.size();
+    for (size_t i = 0; i < std::min(2 * PREFETCH_DISTANCE, n); i++) prefetch_edge(edges[i]);
+    for (size_t i = 0; i < n; i++) {
+        if (i + 2 * PREFETCH_DISTANCE < n) prefetch_edge(edges[i + 2 * PREFETCH_DISTANCE]);
+        if (i + PREFETCH_DISTANCE < n) prefetch_neighbors(edges[i + PREFETCH_DISTANCE]);
+        process_edge(edges[i].u, edges[i].v, edges[i].t, edges[i].sign);
+    }
+}
+
 
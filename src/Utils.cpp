@@ -3,72 +3,53 @@
 //
 
 #include "../include/Utils.h"
+#include "../include/Oracle.h"
+#include "../include/GraphCSR.h"
+#include "../include/FixedSizePQ.h"
+#include "../include/SampledGraph.h"
+#include "hash_set8.hpp"
 
 /**
- * Runs the exact algorithm for counting triangles in a insertion-only, undirected and static graph streams
+ * Runs the exact algorithm for counting triangles in a insertion-only, undirected and static graph streams. The graph
+ * is stored as a degree-oriented CSR (see GraphCSR) and the triangles are counted by compact-forward, merging the sorted
+ * out-neighborhoods of the endpoints of every edge, on num_threads threads. Edges with a negative node id are skipped
+ * with a warning while the graph is built
  * @param dataset_filepath where the graph is stored
  * @param output_path where to write outputs
- * @return the number of triangles in the graph
+ * @param num_threads threads counting the triangles
+ * @param local_output_path if not empty, where to write the local triangles of every node, as rows "node count"
+ * @return the number of triangles in the graph, -1 if the graph could not be built
  */
-long Utils::run_exact_algorithm(std::string &dataset_filepath, std::string &output_path) {
+long Utils::run_exact_algorithm(std::string &dataset_filepath, std::string &output_path, int num_threads,
+                                const std::string &local_output_path) {
 
-    std::ifstream file(dataset_filepath);
-    std::string line, su, sv;
+    std::cout << "Running exact algorithm...\n";
 
-    if (!file.is_open()) {
-        std::cerr << "Error! Unable to open file " << dataset_filepath << "\n";
+    // - graph
+    GraphCSR graph;
+    if (!graph.build(dataset_filepath, GraphCSR::DEFAULT_CHUNK_EDGES, output_path + ".spill")) {
         return -1;
     }
 
-    std::cout << "Running exact algorithm...\n";
-
-    // - graph
-    emhash5::HashMap<int, std::unordered_set<int>> graph_stream;
     // -- local triangles
-    emhash5::HashMap<int, int> local_triangles;
-
-    int u, v, du, dv, n_min, n_max, timestamp;
-    std::unordered_set<int> min_neighbors;
-
-    long total_T = 0, nline = 0;
-    // -- check self-loops
-
-    while (std::getline(file, line)) {
-        nline++;
-
-        std::istringstream iss(line);
-        iss >> u >> v >> timestamp;
-        if (u == v) continue;
-        if (graph_stream[u].find(v) != graph_stream[u].end() and graph_stream[v].find(u) != graph_stream[v].end()) {
-            continue;
-        }
-
-        // -- add edge to graph stream
-        graph_stream[u].emplace(v);
-        graph_stream[v].emplace(u);
-
-        // -- count triangles
-        du = (int) graph_stream[u].size();
-        dv = (int) graph_stream[v].size();
-        n_min = (du < dv) ? u : v;
-        n_max = (du < dv) ? v : u;
-        min_neighbors = graph_stream[n_min];
-        for (const auto &neigh: min_neighbors) {
-            if (graph_stream[n_max].find(neigh) != graph_stream[n_max].end()) {
-                // -- triangle {n_min, neigh, n_max} discovered
-                total_T += 1;
-
-            }
-        }
-
-        if (nline % 3000000 == 0) {
-            printf("Processed %ld edges | Counted %ld triangles\n", nline, total_T);
-        }
-
-
+    bool count_local = !local_output_path.empty();
+    std::vector<uint64_t> local_triangles(count_local ? graph.num_nodes() : 0, 0);
+
+    long total_T;
+    if (count_local) {
+        total_T = (long) graph.parallel_for_each_triangle(num_threads, [&](int u, int v, int w, uint64_t, uint64_t,
+                                                                           uint64_t) {
+            std::atomic_ref<uint64_t>(local_triangles[u]).fetch_add(1, std::memory_order_relaxed);
+            std::atomic_ref<uint64_t>(local_triangles[v]).fetch_add(1, std::memory_order_relaxed);
+            std::atomic_ref<uint64_t>(local_triangles[w]).fetch_add(1, std::memory_order_relaxed);
+        });
+    } else {
+        total_T = (long) graph.parallel_for_each_triangle(num_threads, [](int, int, int, uint64_t, uint64_t,
+                                                                          uint64_t) {});
     }
 
-    long num_nodes = (long) graph_stream.size();
+    long num_nodes = (long) graph.num_nodes();
+    long nline = (long) graph.num_stream_edges();
     printf("Processed dataset with n = %ld, m = %ld\n", num_nodes, nline);
     // -- write results
     std::ofstream out_file(output_path, std::ios::app);
@@ -78,136 +59,132 @@ long Utils::run_exact_algorithm(std::string &dataset_filepath, std::string &outp
     out_file << "Triangles = " << total_T << "\n";
     out_file.close();
 
+    if (count_local) {
+        std::ofstream local_file(local_output_path);
+        for (int u = 0; u < (int) graph.num_nodes(); u++) {
+            if (local_triangles[u] > 0) local_file << graph.original_id(u) << " " << local_triangles[u] << "\n";
+        }
+    }
+
     return total_T;
 }
 
 /**
- * Runs the exact algorithm for counting triangles in a fully dynamic graph stream streams
+ * Runs the exact algorithm for counting triangles in a fully dynamic graph stream streams. The graph is kept in a
+ * SampledGraph (compact neighborhoods, intersected in place without copies), and every event adds or removes the
+ * common neighbors of its endpoints to the count. Self-loops are ignored
  * @param dataset_filepath where the graph is stored
  * @param output_path where to write outputs
+ * @param checkpoint_every if positive, the exact count is written every checkpoint_every events
+ * @param checkpoint_path CSV file of the checkpoints, as rows "events,edges,triangles"
  * @return the number of triangles in the graph
  */
-long Utils::run_exact_algorithm_FD(std::string &dataset_filepath, std::string &output_path) {
+long Utils::run_exact_algorithm_FD(std::string &dataset_filepath, std::string &output_path, long checkpoint_every,
+                                   const std::string &checkpoint_path) {
 
-    std::ifstream file(dataset_filepath);
-    std::string line, su, sv;
+    EdgeStreamReader reader(dataset_filepath);
 
-    if (!file.is_open()) {
-        std::cerr << "Error! Unable to open file " << dataset_filepath << "\n";
+    if (!reader.open()) {
         return -1;
     }
 
+    std::ofstream checkpoint_file;
+    if (checkpoint_every > 0) {
+        checkpoint_file.open(checkpoint_path);
+        if (!checkpoint_file.is_open()) {
+            std::cerr << "Error! Unable to open checkpoint file " << checkpoint_path << "\n";
+            return -1;
+        }
+        checkpoint_file << "events,edges,triangles\n";
+    }
+
     std::cout << "Running exact algorithm for fully dynamic streams...\n";
 
     // - graph
-    emhash5::HashMap<int, std::unordered_set<int>> graph_stream;
-
-    int u, v, du, dv, n_min, n_max, timestamp, src, dst;
-    char sign;
-    std::unordered_set<int> min_neighbors;
-
-    emhash5::HashMap<unsigned long long, std::pair<int, int>> unique_edges;
-    std::unordered_set<int> unique_nodes;
+    SampledGraph graph_stream;
+
+    // -- nodes and edges seen in the stream
+    emhash8::HashSet<unsigned long long, hash_edge_id> unique_edges;
+    std::vector<bool> unique_nodes;
+    long num_unique_nodes = 0;
+    auto see_node = [&](int u) {
+        if ((size_t) u >= unique_nodes.size()) unique_nodes.resize(std::max((size_t) u + 1, 2 * unique_nodes.size()));
+        if (!unique_nodes[u]) {
+            unique_nodes[u] = true;
+            num_unique_nodes++;
+        }
+    };
 
-    long total_T = 0, nline = 0, cum_triangles = 0, num_edges = 0;
+    long total_T = 0, nline = 0;
     long max_edges = 0, time_max_edges = 0;
+    long skipped = 0;
+    size_t counts[3];
 
-    while (std::getline(file, line)) {
+    reader.for_each_edge([&](const StreamEdge &e) {
 
+        int u = std::min(e.u, e.v);
+        int v = std::max(e.u, e.v);
 
-        std::istringstream iss(line);
-        iss >> src >> dst >> timestamp >> sign;
-        u = src;
-        v = dst;
-        if (u > v) {
-            u = dst;
-            v = src;
+        // -- node ids index unique_nodes and the subgraph, so edges with an id outside [0, 2^31 - 1) are not counted
+        if (!SampledGraph::valid_id(u) or !SampledGraph::valid_id(v)) {
+            skipped++;
+            return;
         }
 
-        unique_nodes.emplace(u);
-        unique_nodes.emplace(v);
-
-        // -- count triangles
-        // -- check if u and v are in graph
-        du = (int) graph_stream[u].size();
-        dv = (int) graph_stream[v].size();
-        n_min = (du < dv) ? u : v;
-        n_max = (du < dv) ? v : u;
-        min_neighbors = graph_stream[n_min];
-        cum_triangles = 0;
-
-        for (const auto &neigh: min_neighbors) {
-            if (graph_stream[n_max].find(neigh) != graph_stream[n_max].end()) {
-                // -- triangle {n_min, neigh, n_max} discovered
-                cum_triangles += 1;
+        see_node(u);
+        see_node(v);
+
+        if (u != v) {
+            // -- count triangles
+            graph_stream.count_common_neighbors(u, v, counts);
+            long cum_triangles = (long) (counts[0] + counts[1] + counts[2]);
+
+            // -- check if edge is addition or removal
+            if (e.sign < 0) {
+                total_T -= cum_triangles;
+                graph_stream.remove_edge(u, v);
+            } else {
+                // -- by default, assume addition
+                total_T += cum_triangles;
+                graph_stream.add_edge(u, v, true);
             }
-        }
 
-        // -- check if edge is addition or removal
-        if (sign == '-') {
-            total_T -= cum_triangles;
-            if (graph_stream[u].find(v) != graph_stream[u].end() and
-                graph_stream[v].find(u) != graph_stream[v].end()) {
-                num_edges--;
-                // -- remove edge from graph stream
-                graph_stream[u].erase(v);
-                graph_stream[v].erase(u);
-                // -- erase entry from map if empty
-                if (graph_stream[u].empty())
-                    graph_stream.erase(u);
-                if (graph_stream[v].empty())
-                    graph_stream.erase(v);
-            }
-        } else {
-            // -- by default, assume addition
-            total_T += cum_triangles;
-            if (graph_stream[u].find(v) == graph_stream[u].end() and
-                graph_stream[v].find(u) == graph_stream[v].end()) {
-                num_edges++;
-                // -- add edge to graph stream
-                graph_stream[u].emplace(v);
-                graph_stream[v].emplace(u);
-            }
-        }
-
-
-        // -- update unique edges count
-        if (unique_edges.find(edge_to_id(u, v)) == unique_edges.end()) {
-            if (sign == '+')
-                unique_edges[edge_to_id(u, v)] = {1, 0};
-            else
-                unique_edges[edge_to_id(u, v)] = {0, 1};
-        } else {
-            if (sign == '+')
-                unique_edges[edge_to_id(u, v)].first += 1;
-            else
-                unique_edges[edge_to_id(u, v)].second += 1;
+            // -- update unique edges count
+            unique_edges.insert(edge_to_id(u, v));
         }
 
-
+        long num_edges = (long) graph_stream.num_edges();
         if (num_edges > max_edges) {
             max_edges = num_edges;
             time_max_edges = nline;
         }
 
         nline++;
+        if (checkpoint_every > 0 and nline % checkpoint_every == 0) {
+            checkpoint_file << nline << "," << num_edges << "," << total_T << "\n";
+        }
         if (nline % 3000000 == 0) {
             printf("Processed %ld edges | Subgraph contains: %ld edges - Counted: %ld triangles\n", nline, num_edges, total_T);
         }
 
+    });
+
+    if (checkpoint_every > 0 and nline % checkpoint_every != 0) {
+        checkpoint_file << nline << "," << (long) graph_stream.num_edges() << "," << total_T << "\n";
     }
 
-    long num_nodes = (long) unique_nodes.size();
+    if (skipped > 0) std::cerr << "Warning! Skipped " << skipped << " edges with node ids outside [0, 2^31 - 1)\n";
+    long num_nodes = num_unique_nodes;
     printf("Processed dataset with n = %ld, m = %ld\n", num_nodes, nline);
     printf("Unique edges count: %ld\n", (long) unique_edges.size());
     // -- write results
     std::ofstream out_file(output_path, std::ios::app);
     out_file << "Ground Truth:" << "\n";
     out_file << "Number of Unique Nodes = " << num_nodes << "\n";
-    out_file << "Number of Nodes at the end = " << (long) graph_stream.size() << "\n";
+    out_file << "Number of Nodes at the end = " << (long) graph_stream.num_nodes() << "\n";
     out_file << "Number of Edges = " << nline << "\n";
     out_file << "Maximum Number of Edges = " << max_edges << " at time " << time_max_edges << " in the stream\n";
-    out_file << "Number of Edges at the end = " << num_edges << "\n";
+    out_file << "Number of Edges at the end = " << (long) graph_stream.num_edges() << "\n";
     out_file << "Number of Unique Edges = " << (long) unique_edges.size() << "\n";
     out_file << "Triangles = " << total_T << "\n";
     out_file.close();
@@ -229,6 +206,7 @@ bool Utils::read_node_oracle(std::string &oracle_filename, char delimiter, int s
     std::ifstream file(oracle_filename);
     std::string line;
     int i = 0;
+    long skipped = 0;
     if (file.is_open()) {
         while (std::getline(file, line)) {
             if (i >= skip) {
@@ -238,11 +216,17 @@ bool Utils::read_node_oracle(std::string &oracle_filename, char delimiter, int s
                 int node = std::stoi(token);
                 std::getline(iss, token, delimiter);
                 int label = std::stoi(token);
-                node_oracle.insert_unique(node, label);
+                // -- node ids are the keys of the oracle backends, where a negative id would collide with the empty key
+                if (node < 0) {
+                    skipped++;
+                } else {
+                    node_oracle.insert_unique(node, label);
+                }
             }
             i++;
         }
         file.close();
+        if (skipped > 0) std::cerr << "Warning! Skipped " << skipped << " oracle rows with negative node ids\n";
         return true;
     } else {
         std::cerr << "Error! Unable to open file " << oracle_filename << "\n";
@@ -260,12 +244,13 @@ bool Utils::read_node_oracle(std::string &oracle_filename, char delimiter, int s
  * @return true if the oracle file is read correctly, false otherwise
  */
 bool Utils::read_edge_oracle(std::string &oracle_filename, char delimiter, int skip,
-                             emhash5::HashMap<long, int> &edge_id_oracle) {
+                             emhash5::HashMap<long, int, hash_edge_id> &edge_id_oracle) {
 
 
     std::ifstream file(oracle_filename);
     std::string line;
     int i = 0;
+    long skipped = 0;
     if (file.is_open()) {
         while (std::getline(file, line)) {
             if (i >= skip) {
@@ -277,11 +262,17 @@ bool Utils::read_edge_oracle(std::string &oracle_filename, char delimiter, int s
                 int v = std::stoi(token);
                 std::getline(iss, token, delimiter);
                 int label = std::stoi(token);
-                edge_id_oracle.insert_unique(edge_to_id(u, v), label);
+                // -- edges with a negative id are skipped by the algorithms, so they are not kept in the oracle
+                if (u < 0 or v < 0) {
+                    skipped++;
+                } else {
+                    edge_id_oracle.insert_unique(edge_to_id(u, v), label);
+                }
             }
             i++;
         }
         file.close();
+        if (skipped > 0) std::cerr << "Warning! Skipped " << skipped << " oracle rows with negative node ids\n";
         return true;
     } else {
         std::cerr << "Error! Unable to open file " << oracle_filename << "\n";
@@ -298,9 +289,15 @@ bool Utils::read_edge_oracle(std::string &oracle_filename, char delimiter, int s
  * @param delimiter for rows of graph dataset file
  * @param skip line to skip at the beginning of graph dataset file
  * @param output_path where to store the preprocess graph dataset
+ * @param binary_output true to write the binary stream format (see BinaryStreamHeader), false for text rows
+ * @param mapping_path if not empty, relabel the nodes to the dense ids [0, n) (see NodeRelabelling) and write the
+ * mapping to this file
+ * @param strategy order of the new ids
+ * @return false if the dataset could not be read, or the mapping or the stream could not be written
  */
-void Utils::preprocess_data(const std::string &dataset_filepath, std::string &delimiter, int skip,
-                            std::string &output_path) {
+bool Utils::preprocess_data(const std::string &dataset_filepath, std::string &delimiter, int skip,
+                            std::string &output_path, bool binary_output, const std::string &mapping_path,
+                            NodeRelabelling::Strategy strategy) {
 
     std::cout << "Preprocessing Dataset...\n";
     std::ifstream file(dataset_filepath);
@@ -368,22 +365,92 @@ void Utils::preprocess_data(const std::string &dataset_filepath, std::string &de
         std::sort(ordered_edge_stream.begin(), ordered_edge_stream.end(),
                   [](const std::pair<Edge, int> &a, const std::pair<Edge, int> &b) { return a.second < b.second; });
 
+        // -- relabel the nodes, keeping each edge as (smaller id, larger id)
+        if (!mapping_path.empty()) {
+            std::vector<Edge> edges;
+            edges.reserve(ordered_edge_stream.size());
+            for (const auto &elem: ordered_edge_stream) edges.push_back(elem.first);
+            NodeRelabelling relabelling = NodeRelabelling::build(edges, strategy);
+            if (!relabelling.write(mapping_path)) return false;
+            for (auto &elem: ordered_edge_stream) {
+                int nu = relabelling.new_id(elem.first.first);
+                int nv = relabelling.new_id(elem.first.second);
+                elem.first = {std::min(nu, nv), std::max(nu, nv)};
+            }
+            printf("Relabelled %zu nodes to [0, %zu) by %s, mapping written to %s\n", relabelling.num_nodes(),
+                   relabelling.num_nodes(), NodeRelabelling::strategy_name(strategy), mapping_path.c_str());
+        }
+
         // -- write results
         std::cout << "Done!\nWriting results...\n";
-        std::ofstream out_file(output_path);
+        EdgeStreamWriter out_file(output_path, binary_output, false);
+        if (!out_file.open()) return false;
 
         int cnt = 0;
         for (auto elem: ordered_edge_stream) {
             // -- also, rescale the time (not meant for Tonic)
-            out_file << elem.first.first << " " << elem.first.second << " " << ++cnt << "\n";
+            out_file.write(elem.first.first, elem.first.second, ++cnt);
         }
 
-        out_file.close();
+        return out_file.close(num_nodes);
 
     } else {
         std::cerr << "DataPreprocessing - Error! Graph filepath not opened.\n";
+        return false;
+    }
+
+}
+
+/**
+ * Translate an oracle built on the original node ids to the ids of a relabelled stream, so that it can be used on the
+ * stream written by preprocess_data with the same mapping. Entries of nodes not in the stream are dropped. The oracle
+ * is written in its own format: binary oracles as binary, text oracles as rows by decreasing label
+ * @param oracle_path
+ * @param oracle_type nodes or edges
+ * @param relabelling
+ * @param output_path
+ * @return false if the oracle could not be read or written
+ */
+bool Utils::relabel_oracle(const std::string &oracle_path, const std::string &oracle_type,
+                           const NodeRelabelling &relabelling, const std::string &output_path) {
+    bool edges = oracle_type == "edges";
+    bool binary = Oracle::is_binary_file(oracle_path);
+    std::string path(oracle_path);
+    std::shared_ptr<Oracle> oracle = binary ? Oracle::map_binary_oracle(path)
+                                            : edges ? Oracle::read_edge_oracle(path, ' ', 0)
+                                                    : Oracle::read_node_oracle(path, ' ', 0);
+    if (!oracle) return false;
+    if (oracle->is_edge_oracle() != edges) {
+        std::cerr << "Error! Oracle " << oracle_path << " is not a " << oracle_type << " oracle\n";
+        return false;
+    }
+    std::vector<std::pair<uint64_t, int>> entries;
+    oracle->get_entries(entries);
+    size_t read_entries = entries.size();
+    relabelling.relabel_entries(edges, entries);
+    printf("Relabelled oracle %s || %zu of %zu entries kept, written to %s\n", oracle_path.c_str(), entries.size(),
+           read_entries, output_path.c_str());
+    if (binary) {
+        return Oracle::write_binary_oracle(output_path, edges ? Oracle::Type::EDGES : Oracle::Type::NODES, entries);
     }
 
+    std::sort(entries.begin(), entries.end(), [](const std::pair<uint64_t, int> &a, const std::pair<uint64_t, int> &b) {
+        return a.second > b.second or (a.second == b.second and a.first < b.first);
+    });
+    std::ofstream out_file(output_path);
+    if (!out_file.is_open()) {
+        std::cerr << "Error! Unable to open file " << output_path << "\n";
+        return false;
+    }
+    for (const auto &entry: entries) {
+        if (edges) {
+            auto [u, v] = id_to_edge(entry.first);
+            out_file << u << " " << v << " " << entry.second << "\n";
+        } else {
+            out_file << entry.first << " " << entry.second << "\n";
+        }
+    }
+    return true;
 }
 
 /**
@@ -474,9 +541,10 @@ std::pair<Utils::EdgeStream, long> Utils::preprocess_data_FD(const std::string &
  * @param delimiter for rows of snapshots dataset file
  * @param line_to_skip at the beginning of snapshot dataset file
  * @param output_path where to write the final FD stream
+ * @param binary_output true to write the binary stream format (see BinaryStreamHeader), false for text rows
  */
 void Utils::merge_snapshots_FD(std::string &folder, int n_snapshots, std::string &delimiter, int line_to_skip,
-                            std::string &output_path) {
+                            std::string &output_path, bool binary_output) {
 
     std::vector<EdgeSigned> fd_edge_stream;
     EdgeStream edge_additions;
@@ -579,242 +647,180 @@ void Utils::merge_snapshots_FD(std::string &folder, int n_snapshots, std::string
     std::sort(fd_edge_stream.begin(), fd_edge_stream.end(),
               [](const EdgeSigned &a, const EdgeSigned &b) { return a.first.second < b.first.second; });
 
-    std::ofstream out_file(output_path);
+    EdgeStreamWriter out_file(output_path, binary_output, true);
+    if (!out_file.open()) return;
+    std::unordered_set<int> unique_nodes;
     for (auto &edge: fd_edge_stream) {
-        char sign = (edge.second == 1) ? '+' : '-';
-        out_file << edge.first.first.first << " " << edge.first.first.second << " "
-                 << edge.first.second << " " << sign << "\n";
+        out_file.write(edge.first.first.first, edge.first.first.second, (int) edge.first.second, edge.second);
+        unique_nodes.emplace(edge.first.first.first);
+        unique_nodes.emplace(edge.first.first.second);
     }
 
-    out_file.close();
+    out_file.close(unique_nodes.size());
     std::cout << "Done!\n";
 
 }
 
 /**
- * Function that builds OracleExact, given the graph filepath. Requires to solve the problem of counting exactly the
- * number of triangles in a graph stream.
- * @param filepath of the graph for which deriving OracleExact
- * @param percentage_retain of entries ((u,v); O_H((u, v))) to store sorted by O_H
- * @param output_path where to write OracleExact
+ * Order of the oracle entries: heavier first, ties broken by edge, so that the retained entries and their order do not
+ * depend on the number of threads
  */
-void Utils::build_edge_exact_oracle(std::string &filepath, double percentage_retain, std::string &output_path) {
-
-    std::cout << "Building edge oracle...\n";
-
-    std::ifstream file(filepath);
-    std::string line;
-
-    emhash5::HashMap<Edge, int, hash_edge> oracle_heaviness;
-
-    // -- graph
-    emhash5::HashMap<int, std::unordered_set<int>> graph_stream;
-    std::unordered_set<int> min_neighs;
-
-    long total_T = 0.0;
-    int u, v, t;
-
-    if (file.is_open()) {
-        long nline = 0;
-        while (std::getline(file, line)) {
-            nline++;
-            std::istringstream iss(line);
-            iss >> u >> v >> t;
-            if (u == v) continue;
-            if (graph_stream[u].find(v) != graph_stream[u].end() and graph_stream[v].find(u) != graph_stream[v].end()) {
-                continue;
-            }
-            graph_stream[u].emplace(v);
-            graph_stream[v].emplace(u);
-            int du = (int) graph_stream[u].size();
-            int dv = (int) graph_stream[v].size();
-            int n_min = (du < dv) ? u : v;
-            int n_max = (du < dv) ? v : u;
-            min_neighs = graph_stream[n_min];
-            int common_neighs = 0;
-            for (auto neigh: min_neighs) {
-                if (graph_stream[n_max].find(neigh) != graph_stream[n_max].end()) {
-                    common_neighs++;
-                    int entry_11 = (n_min < neigh) ? n_min : neigh;
-                    int entry_12 = (n_min < neigh) ? neigh : n_min;
-                    int entry_21 = (neigh < n_max) ? neigh : n_max;
-                    int entry_22 = (neigh < n_max) ? n_max : neigh;
-
-                    oracle_heaviness[{entry_11, entry_12}] += 1;
-                    oracle_heaviness[{entry_21, entry_22}] += 1;
-                }
-            }
+struct heavier_edge {
+    bool operator()(const Utils::Heavy_edge &a, const Utils::Heavy_edge &b) const {
+        return a.second > b.second or (a.second == b.second and a.first < b.first);
+    }
+};
 
-            int entry_31 = (u < v) ? u : v;
-            int entry_32 = (u < v) ? v : u;
-            oracle_heaviness[{entry_31, entry_32}] = common_neighs;
-            total_T += common_neighs;
+/**
+ * Build the degree-oriented CSR of the stream for the exact edge oracles
+ * @return false if the graph could not be built
+ */
+static bool build_oracle_graph(std::string &filepath, const std::string &output_path, size_t chunk_edges,
+                               GraphCSR &graph) {
+    if (!graph.build(filepath, chunk_edges, output_path + ".spill")) {
+        std::cerr << "Error! Unable to build the graph of " << filepath << "\n";
+        return false;
+    }
+    printf("Graph || %zu nodes, %zu edges, %zu bytes\n", graph.num_nodes(), graph.num_edges(), graph.memory_bytes());
+    return true;
+}
 
-            if (nline % 3000000 == 0) {
-                printf("Processed %ld edges | Counted %ld triangles\n", nline, total_T);
+/**
+ * Write the top percentage_retain * m edges of the graph by heaviness, heaviest first. Only the retained entries are
+ * kept in memory, in a bounded heap whose top is the lightest of them
+ * @param graph
+ * @param heaviness of every edge, indexed as the edges of the graph
+ * @param percentage_retain
+ * @param output_path
+ * @param binary_output true to write the binary oracle format (see BinaryOracleHeader), false for text rows
+ */
+static void write_top_edges(const GraphCSR &graph, const std::vector<uint32_t> &heaviness, double percentage_retain,
+                            const std::string &output_path, bool binary_output) {
+
+    size_t stop_idx = (size_t) std::max(percentage_retain * (double) graph.num_edges(), 0.0);
+    FixedSizePQ<Utils::Heavy_edge, heavier_edge> top_edges(stop_idx);
+    heavier_edge heavier;
+    for (size_t node = 0; node < graph.num_nodes() and stop_idx > 0; node++) {
+        int u = graph.original_id((int) node);
+        for (uint64_t e = graph.begin((int) node); e < graph.end((int) node); e++) {
+            int v = graph.original_id(graph.target(e));
+            Utils::Heavy_edge entry = {{std::min(u, v), std::max(u, v)}, (int) heaviness[e]};
+            if (top_edges.size() < stop_idx) {
+                top_edges.push(entry);
+            } else if (heavier(entry, top_edges.top())) {
+                top_edges.pop();
+                top_edges.push(entry);
             }
         }
+    }
+    std::vector<Utils::Heavy_edge> sorted_oracle;
+    sorted_oracle.reserve(top_edges.size());
+    while (!top_edges.empty()) {
+        sorted_oracle.push_back(top_edges.top());
+        top_edges.pop();
+    }
+    std::reverse(sorted_oracle.begin(), sorted_oracle.end());
 
-        // -- eof: sort results
+    std::cout << "Full Oracle Size = " << graph.num_edges() << "\n";
+    std::cout << "Writing top " << sorted_oracle.size() << " entries...\n";
 
-        std::cout << "Sorting the oracle and retrieving the top " << percentage_retain << " values...\n";
-        std::vector<std::pair<Edge, int>> sorted_oracle;
-        sorted_oracle.reserve(oracle_heaviness.size());
-        for (auto &elem: oracle_heaviness) {
-            sorted_oracle.emplace_back(elem.first, elem.second);
+    if (binary_output) {
+        std::vector<std::pair<uint64_t, int>> entries;
+        entries.reserve(sorted_oracle.size());
+        for (const auto &elem: sorted_oracle) {
+            entries.emplace_back(Utils::edge_to_id(elem.first.first, elem.first.second), elem.second);
         }
+        Oracle::write_binary_oracle(output_path, Oracle::Type::EDGES, entries);
+        return;
+    }
 
+    std::ofstream out_file(output_path);
+    for (const auto &elem: sorted_oracle) {
+        out_file << elem.first.first << " " << elem.first.second << " " << elem.second << "\n";
+    }
+}
 
-        std::sort(sorted_oracle.begin(), sorted_oracle.end(),
-                  [](const std::pair<Edge, int> &a, const std::pair<Edge, int> &b) { return a.second > b.second; });
-
-        // -- write results
-        std::cout << "Done!\nWriting results...\n";
-        int stop_idx = (int) (percentage_retain * (int) sorted_oracle.size());
-
-        std::ofstream out_file(output_path);
-        std::cout << "Total Triangles -> " << total_T << "\n";
-        std::cout << "Full Oracle Size = " << sorted_oracle.size() << "\n";
+/**
+ * Function that builds OracleExact, given the graph filepath. Requires to solve the problem of counting exactly the
+ * number of triangles in a graph stream: the heaviness of an edge is the number of triangles of the graph it belongs
+ * to. The graph is stored as a degree-oriented CSR (see GraphCSR) and the triangles of each edge are counted by
+ * intersecting out-neighborhoods, on num_threads threads
+ * @param filepath of the graph for which deriving OracleExact
+ * @param percentage_retain of entries ((u,v); O_H((u, v))) to store sorted by O_H
+ * @param output_path where to write OracleExact
+ * @param num_threads threads counting the triangles
+ * @param chunk_edges edges sorted in memory at a time while building the graph
+ * @param binary_output true to write the binary oracle format (see BinaryOracleHeader), false for text rows
+ */
+void Utils::build_edge_exact_oracle(std::string &filepath, double percentage_retain, std::string &output_path,
+                                    int num_threads, size_t chunk_edges, bool binary_output) {
 
-        std::cout << "Writing top " << stop_idx << " entries...\n";
+    std::cout << "Building edge oracle...\n";
 
-        int cnt = 0;
-        for (auto elem: sorted_oracle) {
-            if (cnt >= stop_idx) break;
-            out_file << elem.first.first << " " << elem.first.second << " " << elem.second << "\n";
-            cnt++;
-        }
+    GraphCSR graph;
+    if (!build_oracle_graph(filepath, output_path, chunk_edges, graph)) return;
 
+    std::vector<uint32_t> heaviness(graph.num_edges(), 0);
+    uint64_t total_T = graph.parallel_for_each_triangle(num_threads, [&](int, int, int, uint64_t e_uv, uint64_t e_uw,
+                                                                         uint64_t e_vw) {
+        std::atomic_ref<uint32_t>(heaviness[e_uv]).fetch_add(1, std::memory_order_relaxed);
+        std::atomic_ref<uint32_t>(heaviness[e_uw]).fetch_add(1, std::memory_order_relaxed);
+        std::atomic_ref<uint32_t>(heaviness[e_vw]).fetch_add(1, std::memory_order_relaxed);
+    });
 
-    } else {
-        std::cerr << "Error! Unable to open oracle file " << filepath << "\n";
-    }
+    std::cout << "Total Triangles -> " << total_T << "\n";
+    write_top_edges(graph, heaviness, percentage_retain, output_path, binary_output);
 }
 
 /**
  * Function that builds Oracle-noWR, given the graph filepath. Requires to solve the problem of counting exactly the
- * number of triangles in a graph stream
+ * number of triangles in a graph stream. A triangle is counted on the edge closing it, and on each of its other two
+ * edges only if that edge arrived at least wr_size lines before the closing one (otherwise the triangle is seen while
+ * the edge is still in the waiting room). Edges arrive at their first occurrence in the stream
  * @param filepath of the graph for which deriving Oracle-noWR
  * @param percentage_retain of entries ((u,v); O_H((u, v))) to store sorted by O_H
  * @param output_path where to write Oracle-noWR
  * @param wr_size the dimension of the waiting room. Used to compute the triangles inside the waiting room to be
  * subtracted to the true heaviness to derive Oracle-noWR
+ * @param num_threads threads counting the triangles
+ * @param chunk_edges edges sorted in memory at a time while building the graph
+ * @param binary_output true to write the binary oracle format (see BinaryOracleHeader), false for text rows
  */
 void Utils::build_edge_exact_nowr_oracle(std::string &filepath, double percentage_retain, std::string &output_path,
-                                         int wr_size) {
+                                         int wr_size, int num_threads, size_t chunk_edges, bool binary_output) {
 
     std::cout << "Building edge oracle...\n";
 
-    std::ifstream file(filepath);
-    std::string line;
-
-    emhash5::HashMap<Edge, int, hash_edge> oracle_heaviness;
-    emhash5::HashMap<Edge, int, hash_edge> edge_wr_heaviness;
-    emhash5::HashMap<Edge, int, hash_edge> edge_time_arrival;
-
-    // -- graph
-    emhash5::HashMap<int, std::unordered_set<int>> graph_stream;
-    std::unordered_set<int> min_neighs;
+    GraphCSR graph;
+    if (!build_oracle_graph(filepath, output_path, chunk_edges, graph)) return;
 
-    long total_T = 0.0;
-    int u, v, t, src, dst;
-
-    if (file.is_open()) {
-        long nline = 0;
-        while (std::getline(file, line)) {
-            nline++;
-            std::istringstream iss(line);
-            iss >> src >> dst >> t;
-
-            u = src;
-            v = dst;
-            if (src > dst){
-                u = dst;
-                v = src;
-            }
-
-            if (u == v) continue;
-            if (graph_stream[u].find(v) != graph_stream[u].end() and graph_stream[v].find(u) != graph_stream[v].end()) {
-                continue;
-            }
-
-            edge_time_arrival[{u, v}] = nline;
-
-            graph_stream[u].emplace(v);
-            graph_stream[v].emplace(u);
-
-            int du = (int) graph_stream[u].size();
-            int dv = (int) graph_stream[v].size();
-            int n_min = (du < dv) ? u : v;
-            int n_max = (du < dv) ? v : u;
-            min_neighs = graph_stream[n_min];
-            int common_neighs = 0;
-            for (auto neigh: min_neighs) {
-                if (graph_stream[n_max].find(neigh) != graph_stream[n_max].end()) {
-                    common_neighs++;
-                    int entry_11 = (n_min < neigh) ? n_min : neigh;
-                    int entry_12 = (n_min < neigh) ? neigh : n_min;
-                    int entry_21 = (neigh < n_max) ? neigh : n_max;
-                    int entry_22 = (neigh < n_max) ? n_max : neigh;
-
-                    oracle_heaviness[{entry_11, entry_12}] += 1;
-                    oracle_heaviness[{entry_21, entry_22}] += 1;
-
-                    // -- account for triangles inside the waiting room
-                    if (nline - edge_time_arrival[{entry_11, entry_12}] < wr_size)
-                        edge_wr_heaviness[{entry_11, entry_12}] += 1;
-
-                    if (nline - edge_time_arrival[{entry_21, entry_22}] < wr_size)
-                        edge_wr_heaviness[{entry_21, entry_22}] += 1;
-
-                }
-            }
-
-            int entry_31 = (u < v) ? u : v;
-            int entry_32 = (u < v) ? v : u;
-            oracle_heaviness[{entry_31, entry_32}] = common_neighs;
-            edge_wr_heaviness[{entry_31, entry_32}] = 0;
-
-            total_T += common_neighs;
-
-            if (nline % 3000000 == 0) {
-                printf("Processed %ld edges | Counted %ld triangles\n", nline, total_T);
+    // -- line of the first occurrence of every edge
+    std::vector<long> arrival(graph.num_edges(), 0);
+    EdgeStreamReader reader(filepath);
+    if (!reader.open()) {
+        std::cerr << "Error! Unable to open dataset file " << filepath << "\n";
+        return;
+    }
+    long nline = 0;
+    reader.for_each_edge([&](const StreamEdge &e) {
+        nline++;
+        int64_t id = graph.find_edge(graph.node(e.u), graph.node(e.v));
+        if (id >= 0 and arrival[id] == 0) arrival[id] = nline;
+    });
+
+    std::vector<uint32_t> heaviness(graph.num_edges(), 0);
+    uint64_t total_T = graph.parallel_for_each_triangle(num_threads, [&](int, int, int, uint64_t e_uv, uint64_t e_uw,
+                                                                         uint64_t e_vw) {
+        long t_closing = std::max(arrival[e_uv], std::max(arrival[e_uw], arrival[e_vw]));
+        for (uint64_t e: {e_uv, e_uw, e_vw}) {
+            if (arrival[e] == t_closing or t_closing - arrival[e] >= wr_size) {
+                std::atomic_ref<uint32_t>(heaviness[e]).fetch_add(1, std::memory_order_relaxed);
             }
         }
+    });
 
-        // -- eof: sort results
-
-        std::cout << "Sorting the oracle and retrieving the top " << percentage_retain << " values...\n";
-        std::vector<std::pair<Edge, int>> sorted_oracle;
-        sorted_oracle.reserve(oracle_heaviness.size());
-        for (auto &elem: oracle_heaviness) {
-            sorted_oracle.emplace_back(elem.first, elem.second - edge_wr_heaviness[elem.first]);
-        }
-
-        std::sort(sorted_oracle.begin(), sorted_oracle.end(),
-                  [](const std::pair<Edge, int> &a, const std::pair<Edge, int> &b) { return a.second > b.second; });
-
-        // -- write results
-        std::cout << "Done!\nWriting results...\n";
-        int stop_idx = (int) (percentage_retain * (int) sorted_oracle.size());
-
-        std::ofstream out_file(output_path);
-        std::cout << "Total Triangles -> " << total_T << "\n";
-        std::cout << "Full Oracle Size = " << sorted_oracle.size() << "\n";
-
-        std::cout << "Writing top " << stop_idx << " entries...\n";
-
-        int cnt = 0;
-        for (auto elem: sorted_oracle) {
-            if (cnt >= stop_idx) break;
-            out_file << elem.first.first << " " << elem.first.second << " " << elem.second << "\n";
-            cnt++;
-        }
-
-
-    } else {
-        std::cerr << "Error! Unable to open oracle file " << filepath << "\n";
-    }
+    std::cout << "Total Triangles -> " << total_T << "\n";
+    write_top_edges(graph, heaviness, percentage_retain, output_path, binary_output);
 }
 
 /**
@@ -823,26 +829,34 @@ void Utils::build_edge_exact_nowr_oracle(std::string &filepath, double percentag
  * @param filepath of the graph for which deriving MinDegreePredictor
  * @param percentage_retain of entries (u; deg(u)) to store sorted by deg(u)
  * @param output_path where to write MinDegreePredictor
+ * @param binary_output true to write the binary oracle format (see BinaryOracleHeader), false for text rows
  */
-void Utils::build_node_oracle(std::string &filepath, double percentage_retain, std::string &output_path) {
+void Utils::build_node_oracle(std::string &filepath, double percentage_retain, std::string &output_path,
+                              bool binary_output) {
 
     std::cout << "Building node oracle...\n";
 
-    std::ifstream file(filepath);
-    std::string line;
+    EdgeStreamReader reader(filepath);
 
     emhash5::HashMap<int, int> node_map;
     // std::unordered_map<int, int> node_map;
 
-    int u, v, t;
+    int u, v;
 
-    if (file.is_open()) {
+    if (reader.open()) {
         long nline = 0;
-        while (std::getline(file, line)) {
+        long skipped = 0;
+        reader.for_each_edge([&](const StreamEdge &e) {
             nline++;
-            std::istringstream iss(line);
-            iss >> u >> v >> t;
-            if (u == v) continue;
+            u = e.u;
+            v = e.v;
+            if (u == v) return;
+
+            // -- node ids are the keys of the oracle, so edges with a negative id are not counted
+            if (u < 0 or v < 0) {
+                skipped++;
+                return;
+            }
 
             if (node_map.find(u) != node_map.end())
                 node_map[u] += 1;
@@ -857,7 +871,8 @@ void Utils::build_node_oracle(std::string &filepath, double percentage_retain, s
             if (nline % 3000000 == 0) {
                 printf("Processed %ld edges\n", nline);
             }
-        }
+        });
+        if (skipped > 0) std::cerr << "Warning! Skipped " << skipped << " edges with negative node ids\n";
 
         // -- eof: sort results
         std::cout << "Sorting the oracle and retrieving the top " << percentage_retain << " values...\n";
@@ -876,9 +891,18 @@ void Utils::build_node_oracle(std::string &filepath, double percentage_retain, s
         std::cout << "Done!\nWriting results...\n";
         int stop_idx = (int) (percentage_retain * (int) sorted_oracle.size());
 
-        std::ofstream out_file(output_path);
         std::cout << "Oracle Size = " << sorted_oracle.size() << "\n";
 
+        if (binary_output) {
+            std::vector<std::pair<uint64_t, int>> entries;
+            for (int i = 0; i <= stop_idx and i < (int) sorted_oracle.size(); i++) {
+                entries.emplace_back((uint64_t) sorted_oracle[i].first, sorted_oracle[i].second);
+            }
+            Oracle::write_binary_oracle(output_path, Oracle::Type::NODES, entries);
+            return;
+        }
+
+        std::ofstream out_file(output_path);
         int cnt = 0;
         for (auto elem: sorted_oracle) {
             if (cnt > stop_idx) break;
@@ -887,7 +911,7 @@ void Utils::build_node_oracle(std::string &filepath, double percentage_retain, s
         }
 
     } else {
-        std::cerr << "Error! Unable to open oracle file " << filepath << "\n";
+        std::cerr << "Error! Unable to open dataset file " << filepath << "\n";
     }
 }
 
@@ -3,16 +3,354 @@
 #include "Tonic.h"
 #include "Tonic_FD.h"
 #include "Utils.h"
+#include "Benchmark.h"
+#include "Oracle.h"
+#include "EdgeStreamReader.h"
+#include "PipelinedStreamReader.h"
+#include "GraphCSR.h"
+#include "ColourPartition.h"
+#include "NodeRelabelling.h"
+#include <charconv>
 #include <fstream>
+#include <thread>
+#include <barrier>
+#include <cmath>
+#include <memory>
+#include <span>
 #include <string>
 #include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+using Options = std::unordered_map<std::string, std::string>;
+
+/**
+ * How the Tonic binary reads the stream
+ */
+struct ReaderConfig {
+    // -- getline, mmap or pipelined
+    std::string mode = "getline";
+    size_t batch_size = EdgeStreamReader::DEFAULT_BATCH_SIZE;
+    size_t ring_capacity = PipelinedStreamReader::DEFAULT_RING_CAPACITY;
+};
+
+/**
+ * Return the elapsed time in seconds between two time points
+ * @param start
+ * @param stop
+ * @return elapsed seconds
+ */
+inline double elapsed_seconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point stop) {
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * Print throughput of the parsing and of the algorithm, measured separately
+ * @param reader_name
+ * @param n_edges number of edges read
+ * @param n_bytes number of bytes parsed
+ * @param parse_time seconds spent parsing the stream
+ * @param algo_time seconds spent processing the edges
+ */
+void print_reader_stats(const char *reader_name, long n_edges, size_t n_bytes, double parse_time, double algo_time) {
+    printf("Reader %s || Parse: %ld edges in %.3f s (%.2f M edges/s, %.1f MB/s) || Algorithm: %.3f s (%.2f M edges/s)\n",
+           reader_name, n_edges, parse_time, parse_time > 0 ? n_edges / parse_time / 1e6 : 0.0,
+           parse_time > 0 ? (double) n_bytes / parse_time / (1 << 20) : 0.0, algo_time,
+           algo_time > 0 ? n_edges / algo_time / 1e6 : 0.0);
+}
+
+/**
+ * Print the size of the sampled subgraph at the end of the stream and its memory footprint per sampled edge
+ * @param n_nodes
+ * @param n_edges
+ * @param n_bytes bytes allocated by the subgraph
+ */
+void print_subgraph_stats(long n_nodes, long n_edges, size_t n_bytes) {
+    printf("Sampled subgraph || %ld nodes, %ld edges, %zu bytes (%.1f bytes/edge)\n", n_nodes, n_edges, n_bytes,
+           n_edges > 0 ? (double) n_bytes / n_edges : 0.0);
+}
+
+/**
+ * Print the oracle lookups of a run (hits, misses, misses rejected by the filter if any) and their cost per edge.
+ * The cost of a lookup is measured after the run, replaying the lookups on the first edges of the stream
+ * @param oracle
+ * @param stats lookup counters of the run
+ * @param n_edges edges processed by the run
+ * @param dataset_path
+ */
+void print_oracle_stats(const Oracle &oracle, const Oracle::Stats &stats, unsigned long long n_edges,
+                        std::string &dataset_path) {
+    const size_t max_sample = 1 << 20;
+    std::vector<StreamEdge> sample;
+    EdgeStreamReader stream_reader(dataset_path);
+    if (stream_reader.open()) {
+        StreamEdge batch[1024];
+        size_t n;
+        while (sample.size() < max_sample and (n = stream_reader.next_batch(batch, 1024)) > 0) {
+            sample.insert(sample.end(), batch, batch + n);
+        }
+    }
+    double ns_per_lookup = 0.0;
+    if (!sample.empty()) {
+        Oracle::Stats replay;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &e: sample) oracle.get_heaviness(e.u, e.v, replay);
+        ns_per_lookup = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                        (double) sample.size();
+    }
+    size_t misses = stats.lookups - stats.hits;
+    double lookups_per_edge = n_edges > 0 ? (double) stats.lookups / (double) n_edges : 0.0;
+    printf("Oracle lookups || %zu lookups (%.3f/edge), %zu hits, %zu misses", stats.lookups, lookups_per_edge,
+           stats.hits, misses);
+    if (oracle.has_filter()) printf(" (%zu rejected by the filter)", stats.filtered);
+    printf(" || %.1f ns/lookup, %.1f ns/edge\n", ns_per_lookup, ns_per_lookup * lookups_per_edge);
+}
+
+/**
+ * Return the number of nodes of a binary stream whose node ids are the dense range [0, n), as written by
+ * DataPreprocessing --relabel, or 0 if the stream is not binary or its ids are not dense
+ * @param dataset_path
+ */
+size_t dense_num_nodes(const std::string &dataset_path) {
+    EdgeStreamReader stream_reader(dataset_path);
+    if (!EdgeStreamReader::is_binary_file(dataset_path) or !stream_reader.open()) return 0;
+    const BinaryStreamHeader &header = stream_reader.header();
+    return header.num_nodes > 0 and header.max_node_id + 1 == header.num_nodes ? (size_t) header.num_nodes : 0;
+}
+
+/**
+ * Read stream through the memory-mapped reader and apply process to each batch of edges, in stream order. Parsing
+ * and processing are timed separately on each batch.
+ * @param dataset_path
+ * @param batch_size number of edges parsed per batch
+ * @param process callable taking a std::span<const StreamEdge>
+ */
+template<typename Process>
+void run_mmap_reader(std::string &dataset_path, size_t batch_size, Process &&process) {
+
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+
+    std::vector<StreamEdge> batch(batch_size);
+    double parse_time = 0.0, algo_time = 0.0;
+    long n_line = 0;
+
+    while (true) {
+        auto t0 = std::chrono::steady_clock::now();
+        size_t n = reader.next_batch(batch.data(), batch.size());
+        auto t1 = std::chrono::steady_clock::now();
+        parse_time += elapsed_seconds(t0, t1);
+        if (n == 0) break;
+
+        process(std::span<const StreamEdge>(batch.data(), n));
+        algo_time += elapsed_seconds(t1, std::chrono::steady_clock::now());
+        n_line += (long) n;
+    }
+
+    print_reader_stats("mmap", n_line, reader.bytes_read(), parse_time, algo_time);
+
+}
+
+/**
+ * Read stream through the pipelined reader: a producer thread parses batches into a ring, while the current thread
+ * applies process to each batch of edges, in stream order. Reports the stall time of both sides.
+ * @param dataset_path
+ * @param batch_size number of edges parsed per batch
+ * @param ring_capacity number of batches in flight between the producer and the current thread
+ * @param process callable taking a std::span<const StreamEdge>
+ */
+template<typename Process>
+void run_pipelined_reader(std::string &dataset_path, size_t batch_size, size_t ring_capacity, Process &&process) {
+
+    PipelinedStreamReader reader(dataset_path, batch_size, ring_capacity);
+    if (!reader.start()) return;
+
+    long n_line = 0;
+    size_t n;
+    const StreamEdge *batch;
+    auto start = std::chrono::steady_clock::now();
+    while ((batch = reader.next_batch(n)) != nullptr) {
+        process(std::span<const StreamEdge>(batch, n));
+        n_line += (long) n;
+    }
+    double total_time = elapsed_seconds(start, std::chrono::steady_clock::now());
+    reader.join();
+
+    print_reader_stats("pipelined", n_line, reader.bytes_read(), reader.parse_time(),
+                       total_time - reader.consumer_stall_time());
+    printf("Pipeline stalls || Producer waited %.3f s on a full ring || Consumer waited %.3f s on an empty ring"
+           " (batch size = %zu, ring capacity = %zu)\n", reader.producer_stall_time(), reader.consumer_stall_time(),
+           batch_size, ring_capacity);
+
+}
+
+/**
+ * Read stream with the configured reader and apply process to each batch of edges, in stream order
+ * @param dataset_path
+ * @param config the reader configuration (mmap or pipelined)
+ * @param process callable taking a std::span<const StreamEdge>
+ */
+template<typename Process>
+void run_stream_reader(std::string &dataset_path, const ReaderConfig &config, Process &&process) {
+    if (config.mode == "pipelined") {
+        run_pipelined_reader(dataset_path, config.batch_size, config.ring_capacity, process);
+    } else {
+        run_mmap_reader(dataset_path, config.batch_size, process);
+    }
+}
+
+/**
+ * Read stream through the memory-mapped reader and broadcast each batch to num_threads worker threads. Batches are
+ * double-buffered: while the workers process one batch, the current thread parses the next one, and a barrier hands
+ * it over once every worker is done with the previous one.
+ * @param dataset_path
+ * @param batch_size number of edges parsed per batch
+ * @param num_threads worker threads, each seeing every edge of the stream in order
+ * @param process callable taking the index of the worker and a std::span<const StreamEdge>, called concurrently
+ */
+template<typename Process>
+void run_broadcast_reader(std::string &dataset_path, size_t batch_size, int num_threads, Process &&process) {
+
+    EdgeStreamReader reader(dataset_path);
+    if (!reader.open()) return;
+
+    std::vector<StreamEdge> batches[2] = {std::vector<StreamEdge>(batch_size), std::vector<StreamEdge>(batch_size)};
+    size_t sizes[2] = {0, 0};
+    std::barrier sync((std::ptrdiff_t) num_threads + 1);
+
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < num_threads; thread++) {
+        workers.emplace_back([&, thread]() {
+            for (int b = 0;; b ^= 1) {
+                sync.arrive_and_wait();
+                if (sizes[b] == 0) return;
+                process(thread, std::span<const StreamEdge>(batches[b].data(), sizes[b]));
+            }
+        });
+    }
+
+    double parse_time = 0.0;
+    long n_line = 0;
+    auto start = std::chrono::steady_clock::now();
+    sizes[0] = reader.next_batch(batches[0].data(), batch_size);
+    parse_time += elapsed_seconds(start, std::chrono::steady_clock::now());
+    for (int b = 0;; b ^= 1) {
+        // -- the instances start on batch b
+        sync.arrive_and_wait();
+        if (sizes[b] == 0) break;
+        n_line += (long) sizes[b];
+        auto t0 = std::chrono::steady_clock::now();
+        sizes[b ^ 1] = reader.next_batch(batches[b ^ 1].data(), batch_size);
+        parse_time += elapsed_seconds(t0, std::chrono::steady_clock::now());
+    }
+    for (auto &worker: workers) worker.join();
+    double total_time = elapsed_seconds(start, std::chrono::steady_clock::now());
+
+    print_reader_stats("broadcast", n_line, reader.bytes_read(), parse_time, total_time);
+
+}
+
+/**
+ * Parse the optional trailing arguments of the form --key=value (or --key, meaning --key=1)
+ * @param argc
+ * @param argv
+ * @param first index of the first optional argument
+ * @param allowed names of the accepted options
+ * @param options the filled map from option name to value
+ * @return true if all optional arguments are well-formed and accepted, false otherwise
+ */
+bool parse_options(int argc, char **argv, int first, const std::unordered_set<std::string> &allowed,
+                   Options &options) {
+    for (int i = first; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.rfind("--", 0) != 0) {
+            std::cerr << "Error! Unexpected argument " << arg << "\n";
+            return false;
+        }
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+        if (allowed.find(key) == allowed.end()) {
+            std::cerr << "Error! Unknown option --" << key << "\n";
+            return false;
+        }
+        options[key] = eq == std::string::npos ? "1" : arg.substr(eq + 1);
+    }
+    return true;
+}
+
+/**
+ * Return the value of an optional argument
+ * @param options
+ * @param key
+ * @param default_value returned if the option is not set
+ * @return the value of the option
+ */
+std::string get_option(const Options &options, const std::string &key, const std::string &default_value) {
+    auto it = options.find(key);
+    return it != options.end() ? it->second : default_value;
+}
+
+/**
+ * Return the value of an optional argument holding a number
+ * @param options
+ * @param key
+ * @param default_value used if the option is not set
+ * @param value the number
+ * @return false if the whole value is not a number of type T, true otherwise
+ */
+template<typename T>
+bool get_number_option(const Options &options, const std::string &key, T default_value, T &value) {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        value = default_value;
+        return true;
+    }
+    const char *first = it->second.data(), *last = first + it->second.size();
+    auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc() or end != last or first == last) {
+        std::cerr << "Error! Invalid value of --" << key << ": " << it->second << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read the --format option of the preprocessing executables
+ * @param options
+ * @param binary_output set to true if the binary stream format is requested
+ * @return true if the format is text or binary, false otherwise
+ */
+bool get_format_option(const Options &options, bool &binary_output) {
+    std::string format = get_option(options, "format", "text");
+    if (format != "text" and format != "binary") {
+        std::cerr << "Error! Format must be text or binary\n";
+        return false;
+    }
+    binary_output = format == "binary";
+    return true;
+}
 
 /**
  * Read stream and perform the Tonic algorithm for insertion only streams
  * @param dataset_path
  * @param algo the instantiated Tonic algorithm class
+ * @param reader how to read the stream: getline (std::getline + std::stoi, text streams only), mmap (zero-copy
+ * memory-mapped reader, text or binary streams) or pipelined (mmap reader on a background producer thread)
  */
-void run_tonic_algo(std::string &dataset_path, Tonic &algo) {
+void run_tonic_algo(std::string &dataset_path, Tonic &algo, const ReaderConfig &reader) {
+
+    if (reader.mode != "getline") {
+        long n_line = 0;
+        run_stream_reader(dataset_path, reader, [&](std::span<const StreamEdge> batch) {
+            algo.process_edges(batch);
+            long prev_line = n_line;
+            n_line += (long) batch.size();
+            if (n_line / 5000000 != prev_line / 5000000) {
+                printf("Processed %ld edges || Estimated count T = %f\n", n_line, algo.get_global_triangles());
+            }
+        });
+        return;
+    }
 
     std::ifstream file(dataset_path);
     std::string line;
@@ -50,8 +388,23 @@ void run_tonic_algo(std::string &dataset_path, Tonic &algo) {
  * Read stream and perform the Tonic FD algorithm for fully dynamic streams
  * @param dataset_path
  * @param algo the instantiated Tonic FD algorithm class
+ * @param reader how to read the stream: getline (std::getline + std::stoi, text streams only), mmap (zero-copy
+ * memory-mapped reader, text or binary streams) or pipelined (mmap reader on a background producer thread)
  */
-void run_tonic_algo_FD(std::string &dataset_path, Tonic_FD &algo) {
+void run_tonic_algo_FD(std::string &dataset_path, Tonic_FD &algo, const ReaderConfig &reader) {
+
+    if (reader.mode != "getline") {
+        long n_line = 0;
+        run_stream_reader(dataset_path, reader, [&](std::span<const StreamEdge> batch) {
+            algo.process_edges(batch);
+            long prev_line = n_line;
+            n_line += (long) batch.size();
+            if (n_line / 5000000 != prev_line / 5000000) {
+                printf("Processed %ld edges || Estimated count T = %f\n", n_line, algo.get_global_triangles());
+            }
+        });
+        return;
+    }
 
     std::ifstream file(dataset_path);
     std::string line;
@@ -92,6 +445,25 @@ void run_tonic_algo_FD(std::string &dataset_path, Tonic_FD &algo) {
 
 }
 
+/**
+ * Write the local triangle estimates of a run as `node estimate` rows, by decreasing estimate
+ * @param top_nodes (node, estimate) pairs, sorted by decreasing estimate
+ * @param output_path
+ * @param memory_bytes bytes used by the local estimates
+ */
+void write_local_estimates(const std::vector<std::pair<int, double>> &top_nodes, const std::string &output_path,
+                           size_t memory_bytes) {
+    std::ofstream out_file(output_path);
+    if (!out_file.is_open()) {
+        std::cerr << "Error! Unable to open file " << output_path << "\n";
+        return;
+    }
+    out_file << std::fixed;
+    for (const auto &[node, estimate]: top_nodes) out_file << node << " " << estimate << "\n";
+    printf("Local estimates || %zu nodes written to %s || %zu bytes of local counts\n", top_nodes.size(),
+           output_path.c_str(), memory_bytes);
+}
+
 /**
  * Write results to a csv file
  * @param name of the algorithm
@@ -122,6 +494,219 @@ void write_results(std::string name, double estimated_T, double time, std::strin
 
 }
 
+/**
+ * Aggregate of the global estimates of the instances of an ensemble
+ */
+struct EnsembleEstimate {
+    double mean = 0.0;
+    double median_of_means = 0.0;
+    // -- sample variance of the estimates of the instances
+    double variance = 0.0;
+};
+
+/**
+ * Aggregate the estimates of the instances of an ensemble. The median of means splits the instances, in order, into
+ * groups of sizes differing by at most one, and takes the median of the group means
+ * @param estimates one per instance
+ * @param groups number of groups of the median of means, clamped to [1, number of instances]
+ * @return the aggregated estimates
+ */
+EnsembleEstimate aggregate_estimates(const std::vector<double> &estimates, int groups) {
+    EnsembleEstimate aggregate;
+    int n = (int) estimates.size();
+    if (n == 0) return aggregate;
+    for (double x: estimates) aggregate.mean += x / n;
+    for (double x: estimates) aggregate.variance += n > 1 ? (x - aggregate.mean) * (x - aggregate.mean) / (n - 1) : 0.0;
+
+    groups = std::max(1, std::min(groups, n));
+    std::vector<double> group_means;
+    for (int g = 0; g < groups; g++) {
+        int first = (int) ((long) g * n / groups), last = (int) ((long) (g + 1) * n / groups);
+        double sum = 0.0;
+        for (int i = first; i < last; i++) sum += estimates[i];
+        group_means.push_back(sum / (last - first));
+    }
+    std::sort(group_means.begin(), group_means.end());
+    aggregate.median_of_means = groups % 2 == 1 ? group_means[groups / 2] :
+                                (group_means[groups / 2 - 1] + group_means[groups / 2]) / 2;
+    return aggregate;
+}
+
+/**
+ * Write the aggregated estimates of an ensemble to a csv file
+ * @param name of the algorithm
+ * @param estimates of global triangles, one per instance
+ * @param groups number of groups of the median of means
+ * @param time taken by the ensemble
+ * @param output_path output file where to write results
+ * @param edge_oracle_flag
+ * @param alpha
+ * @param beta
+ * @param memory_budget of each instance
+ * @return the aggregated estimates
+ */
+EnsembleEstimate write_ensemble_results(std::string name, const std::vector<double> &estimates, int groups, double time,
+                                        std::string &output_path, bool edge_oracle_flag, double alpha, double beta,
+                                        long memory_budget) {
+    EnsembleEstimate aggregate = aggregate_estimates(estimates, groups);
+    groups = std::max(1, std::min(groups, (int) estimates.size()));
+    for (size_t i = 0; i < estimates.size(); i++) {
+        printf("Instance %zu || Estimated count T = %f\n", i, estimates[i]);
+    }
+    printf("%s Ensemble of %zu instances || Mean T = %f || Median of %d means T = %f || Variance = %f"
+           " (std error of the mean = %f)\n", name.c_str(), estimates.size(), aggregate.mean, groups,
+           aggregate.median_of_means, aggregate.variance,
+           std::sqrt(aggregate.variance / (double) std::max<size_t>(1, estimates.size())));
+
+    // -- the rows of successive runs are appended under a single header
+    std::string ensemble_path = output_path + "_ensemble.csv";
+    std::error_code error;
+    bool write_header = std::filesystem::file_size(ensemble_path, error) == 0 or error;
+    std::ofstream out_file(ensemble_path, std::ios::app);
+    std::string oracle_type_str = edge_oracle_flag ? "Edges" : "Nodes";
+    if (write_header) out_file << "Algo,Params,Oracle,MemEdges,Instances,Groups,Mean,MedianOfMeans,Variance,Time\n";
+    out_file << name.c_str() << ",Alpha=" << alpha << "-Beta=" << beta << "," << oracle_type_str << ","
+             << memory_budget << "," << estimates.size() << "," << groups << "," << std::fixed << aggregate.mean << ","
+             << aggregate.median_of_means << "," << aggregate.variance << "," << time << "\n";
+    out_file.close();
+    return aggregate;
+}
+
+/**
+ * Run an ensemble of instances of Tonic or Tonic_FD over a single pass of the stream, one thread per instance, and
+ * write the mean of their estimates as the global count, along with the aggregated estimates of the ensemble
+ * @param name of the algorithm
+ * @param instances sharing the same oracle, with different seeds
+ * @param process callable taking an instance and a std::span<const StreamEdge>
+ * @param groups number of groups of the median of means
+ * @param dataset_path
+ * @param batch_size number of edges parsed per batch
+ * @param output_path
+ * @param oracle shared by the instances
+ * @param alpha
+ * @param beta
+ * @param memory_budget of each instance
+ * @param size_oracle size of the oracle in memory
+ * @param time_oracle time to read the oracle
+ */
+template<typename Algo, typename Process>
+void run_tonic_ensemble(const std::string &name, std::vector<std::unique_ptr<Algo>> &instances, Process &&process,
+                        int groups, std::string &dataset_path, size_t batch_size, std::string &output_path,
+                        const Oracle &oracle, double alpha, double beta, long memory_budget, int size_oracle,
+                        double time_oracle) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+    run_broadcast_reader(dataset_path, batch_size, (int) instances.size(),
+                         [&](int i, std::span<const StreamEdge> batch) { process(*instances[i], batch); });
+    double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
+
+    std::vector<double> estimates;
+    long n_nodes = 0, n_edges = 0;
+    size_t n_bytes = 0;
+    Oracle::Stats stats;
+    unsigned long long edges_processed = 0;
+    for (const auto &algo: instances) {
+        estimates.push_back(algo->get_global_triangles());
+        n_nodes += algo->get_num_nodes();
+        n_edges += algo->get_num_edges();
+        n_bytes += algo->get_subgraph_memory();
+        stats.lookups += algo->get_oracle_stats().lookups;
+        stats.hits += algo->get_oracle_stats().hits;
+        stats.filtered += algo->get_oracle_stats().filtered;
+        edges_processed += algo->get_edges_processed();
+    }
+
+    EnsembleEstimate aggregate = write_ensemble_results(name, estimates, groups, time, output_path,
+                                                        oracle.is_edge_oracle(), alpha, beta, memory_budget);
+    write_results(name, aggregate.mean, time, output_path, oracle.is_edge_oracle(), alpha, beta, memory_budget,
+                  size_oracle, time_oracle);
+    print_subgraph_stats(n_nodes, n_edges, n_bytes);
+    print_oracle_stats(oracle, stats, edges_processed, dataset_path);
+}
+
+/**
+ * Run Tonic sharded by colour triples (see ColourPartition) over a single pass of the stream. Shard i runs its own
+ * instance, seeded with random_seed + i, with a share of memory_budget proportional to the expected number of edges
+ * routed to it, so that the shards use memory_budget edges in total. Shards are assigned round-robin to num_threads
+ * threads; every thread reads the whole stream and feeds each edge to the shards it owns among those the edge is
+ * routed to. The global estimate is the sum of the estimates of the shards
+ * @param num_colours
+ * @param num_threads
+ * @param random_seed
+ * @param memory_budget total over the shards
+ * @param alpha
+ * @param beta
+ * @param oracle shared by the shards
+ * @param hub_degree
+ * @param sl_skip_sampling
+ * @param dataset_path
+ * @param batch_size number of edges parsed per batch
+ * @param output_path
+ * @param size_oracle size of the oracle in memory
+ * @param time_oracle time to read the oracle
+ */
+void run_tonic_sharded(int num_colours, int num_threads, int random_seed, long memory_budget, double alpha, double beta,
+                       const std::shared_ptr<Oracle> &oracle, uint32_t hub_degree, bool sl_skip_sampling,
+                       std::string &dataset_path, size_t batch_size, std::string &output_path, int size_oracle,
+                       double time_oracle) {
+
+    auto colours = std::make_shared<const ColourPartition>(num_colours, (uint64_t) random_seed);
+    int c = colours->num_colours();
+    int num_shards = colours->num_shards();
+    num_threads = std::max(1, std::min(num_threads, num_shards));
+
+    std::vector<std::unique_ptr<Tonic>> shards;
+    for (int i = 0; i < num_shards; i++) {
+        long shard_budget = std::max(10L, std::lround((double) memory_budget * colours->edge_share(i) / c));
+        shards.push_back(std::make_unique<Tonic>(random_seed + i, shard_budget, alpha, beta));
+        shards.back()->set_oracle(oracle);
+        shards.back()->set_hub_degree(hub_degree);
+        shards.back()->set_sl_skip_sampling(sl_skip_sampling);
+        shards.back()->set_colour_shard(colours, i);
+    }
+    // -- shards of each colour pair owned by each thread
+    std::vector<std::vector<std::vector<int>>> owned(num_threads, std::vector<std::vector<int>>((size_t) c * c));
+    for (int a = 0; a < c; a++) {
+        for (int b = 0; b < c; b++) {
+            for (int shard: colours->shards_of(a, b)) owned[shard % num_threads][a * c + b].push_back(shard);
+        }
+    }
+    printf("Sharded run || %d colours, %d shards on %d threads\n", c, num_shards, num_threads);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    run_broadcast_reader(dataset_path, batch_size, num_threads, [&](int thread, std::span<const StreamEdge> batch) {
+        for (const StreamEdge &e: batch) {
+            for (int shard: owned[thread][colours->colour(e.u) * c + colours->colour(e.v)]) {
+                shards[shard]->process_edge(e.u, e.v);
+            }
+        }
+    });
+    double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
+
+    double estimated_T = 0.0;
+    long n_nodes = 0, n_edges = 0;
+    size_t n_bytes = 0;
+    Oracle::Stats stats;
+    unsigned long long edges_processed = 0;
+    for (const auto &algo: shards) {
+        estimated_T += algo->get_global_triangles();
+        n_nodes += algo->get_num_nodes();
+        n_edges += algo->get_num_edges();
+        n_bytes += algo->get_subgraph_memory();
+        stats.lookups += algo->get_oracle_stats().lookups;
+        stats.hits += algo->get_oracle_stats().hits;
+        stats.filtered += algo->get_oracle_stats().filtered;
+        edges_processed += algo->get_edges_processed();
+    }
+
+    write_results(std::string("TonicINS-Sharded"), estimated_T, time, output_path, oracle->is_edge_oracle(), alpha,
+                  beta, memory_budget, size_oracle, time_oracle);
+    print_subgraph_stats(n_nodes, n_edges, n_bytes);
+    print_oracle_stats(*oracle, stats, edges_processed, dataset_path);
+}
+
 /**
  * Get the base name of the executable
  * @param s the string to split
@@ -153,17 +738,45 @@ int main(int argc, char **argv) {
 
     // -- data preprocessing
     if (strcmp(project, "DataPreprocessing") == 0) {
-        if (argc != 5) {
+        Options options;
+        bool binary_output;
+        NodeRelabelling::Strategy strategy;
+        if (argc < 5 or !parse_options(argc, argv, 5, {"format", "relabel", "mapping-output", "relabel-oracle",
+                                                        "oracle-type", "oracle-output"}, options) or
+            !get_format_option(options, binary_output) or
+            !NodeRelabelling::parse_strategy(get_option(options, "relabel", "id"), strategy)) {
             std::cerr << "Usage: DataPreprocessing <dataset_path> <delimiter> <skip>"
-                         " <output_path>\n";
+                         " <output_path> [--format=text|binary] [--relabel=id|degree|first|rcm]"
+                         " [--mapping-output=<path>] [--relabel-oracle=<oracle_path>"
+                         " --oracle-type=nodes|edges] [--oracle-output=<path>]\n";
             return 1;
         } else {
             std::string dataset_path(argv[1]);
             std::string delimiter (argv[2]);
             int skip = atoi(argv[3]);
             std::string output_path(argv[4]);
+            // -- with --relabel, nodes get the dense ids [0, n), and the mapping is written next to the stream
+            std::string mapping_path = options.count("relabel") ?
+                                       get_option(options, "mapping-output", output_path + ".mapping") : "";
+            std::string oracle_path = get_option(options, "relabel-oracle", "");
+            std::string oracle_type = get_option(options, "oracle-type", "");
+            if (!oracle_path.empty() and (mapping_path.empty() or (oracle_type != "nodes" and oracle_type != "edges"))) {
+                std::cerr << "Error! --relabel-oracle needs --relabel and --oracle-type=nodes|edges\n";
+                return 1;
+            }
             auto start = std::chrono::high_resolution_clock::now();
-            Utils::preprocess_data(dataset_path, delimiter, skip, output_path);
+            if (!Utils::preprocess_data(dataset_path, delimiter, skip, output_path, binary_output, mapping_path,
+                                        strategy)) {
+                return 1;
+            }
+            // -- translate an oracle built on the original ids with the mapping just written
+            NodeRelabelling relabelling;
+            if (!oracle_path.empty() and
+                (!NodeRelabelling::read(mapping_path, relabelling) or
+                 !Utils::relabel_oracle(oracle_path, oracle_type, relabelling,
+                                        get_option(options, "oracle-output", oracle_path + ".relabelled")))) {
+                return 1;
+            }
             auto stop = std::chrono::high_resolution_clock::now();
             double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
             std::cout << "Dataset preprocessed in time: " << time << " s\n";
@@ -173,24 +786,43 @@ int main(int argc, char **argv) {
 
     // -- run exact
     if (strcmp(project, "RunExactAlgo") == 0) {
-        if (argc != 4) {
+        Options options;
+        int num_threads;
+        long checkpoint_every;
+        if (argc < 4 or !parse_options(argc, argv, 4, {"threads", "local-output", "checkpoint-every",
+                                                        "checkpoint-output"}, options) or
+            !get_number_option<int>(options, "threads", (int) std::max(1u, std::thread::hardware_concurrency()),
+                                    num_threads) or
+            !get_number_option(options, "checkpoint-every", 0L, checkpoint_every)) {
             std::cerr << "Usage: RunExactAlgo <flag: 0: insertion-only stream, 1: fully-dynamic stream>"
-                         " <preprocessed_dataset_path> <output_path>\n";
+                         " <preprocessed_dataset_path> <output_path> [--threads=<n>] [--local-output=<path>]"
+                         " [--checkpoint-every=<events>] [--checkpoint-output=<path>]\n";
             return 1;
         } else {
             int flag_fd = atoi(argv[1]);
             assert(flag_fd == 0 or flag_fd == 1);
+            if (flag_fd == 1 and (options.count("threads") or options.count("local-output"))) {
+                std::cerr << "Error! --threads and --local-output are only for insertion-only streams\n";
+                return 1;
+            }
             std::string dataset_path(argv[2]);
             std::string output_path(argv[3]);
+            std::string local_output_path = get_option(options, "local-output", "");
+            std::string checkpoint_path = get_option(options, "checkpoint-output", output_path + ".checkpoints.csv");
             auto start = std::chrono::high_resolution_clock::now();
             long total_T;
             if (flag_fd == 1)
-                total_T = Utils::run_exact_algorithm_FD(dataset_path, output_path);
+                total_T = Utils::run_exact_algorithm_FD(dataset_path, output_path, checkpoint_every, checkpoint_path);
             else
-                total_T = Utils::run_exact_algorithm(dataset_path, output_path);
+                total_T = Utils::run_exact_algorithm(dataset_path, output_path, std::max(num_threads, 1),
+                                                     local_output_path);
 
             auto stop = std::chrono::high_resolution_clock::now();
             double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
+            if (total_T < 0) {
+                std::cerr << "Error! Unable to run the exact algorithm on " << dataset_path << "\n";
+                return 1;
+            }
             printf("Exact Algorithm successfully run in time %.3f! Total count T = %ld\n", time, total_T);
             return 0;
         }
@@ -198,36 +830,55 @@ int main(int argc, char **argv) {
 
     // -- build oracle
     if (strcmp(project, "BuildOracle") == 0) {
-        if (argc < 5 or argc > 6) {
-            std::cerr << "Usage: BuildOracle <preprocessed_dataset_path> <type = [Exact, noWR, Node]>, <percentage_retain>,"
-                         " <output_path>, [<wr_size>] \n";
+        // -- the optional wr_size is followed by --options
+        int first_option = (argc > 5 and strncmp(argv[5], "--", 2) != 0) ? 6 : 5;
+        Options options;
+        bool binary_output;
+        int num_threads;
+        size_t chunk_edges;
+        if (argc < 5 or !parse_options(argc, argv, first_option, {"format", "threads", "chunk-edges"}, options) or
+            !get_format_option(options, binary_output) or
+            !get_number_option<int>(options, "threads", (int) std::max(1u, std::thread::hardware_concurrency()),
+                                    num_threads) or
+            !get_number_option(options, "chunk-edges", GraphCSR::DEFAULT_CHUNK_EDGES, chunk_edges)) {
+            std::cerr << "Usage: BuildOracle <preprocessed_dataset_path> <type = [Exact, noWR, Node]>,"
+                         " <percentage_retain>, <output_path>, [<wr_size>] [--format=text|binary]"
+                         " [--threads=<n>] [--chunk-edges=<edges>]\n";
             return 1;
         } else {
             std::string dataset_path(argv[1]);
             std::string type_oracle(argv[2]);
             double percentage_retain = atof(argv[3]);
             std::string output_path(argv[4]);
+            num_threads = std::max(num_threads, 1);
+            chunk_edges = std::max<size_t>(chunk_edges, 1);
             auto start = std::chrono::high_resolution_clock::now();
             if (strcmp(type_oracle.c_str(), "Exact") == 0) {
-                Utils::build_edge_exact_oracle(dataset_path, percentage_retain, output_path);
+                Utils::build_edge_exact_oracle(dataset_path, percentage_retain, output_path, num_threads, chunk_edges,
+                                               binary_output);
                 auto stop = std::chrono::high_resolution_clock::now();
                 double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
                 printf("Exact Edge Oracle successfully run in time %.3f!\n", time);
 
             } else if(strcmp(type_oracle.c_str(), "noWR") == 0) {
+                if (first_option != 6) {
+                    std::cerr << "Build Oracle - Error! noWR oracle requires <wr_size>.\n";
+                    return 1;
+                }
                 int wr_size = atoi(argv[5]);
-                Utils::build_edge_exact_nowr_oracle(dataset_path, percentage_retain, output_path, wr_size);
+                Utils::build_edge_exact_nowr_oracle(dataset_path, percentage_retain, output_path, wr_size,
+                                                    num_threads, chunk_edges, binary_output);
                 auto stop = std::chrono::high_resolution_clock::now();
                 double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
                 printf("Exact-noWR Edge Oracle successfully run in time %.3f!\n", time);
             } else if (strcmp(type_oracle.c_str(), "Node") == 0) {
-                    Utils::build_node_oracle(dataset_path, percentage_retain, output_path);
+                    Utils::build_node_oracle(dataset_path, percentage_retain, output_path, binary_output);
                     auto stop = std::chrono::high_resolution_clock::now();
                     double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
                     printf("Node Map successfully run in time %.3f!\n", time);
 
                 } else {
-                std::cerr << "Build Oracle - Error! Type of Oracle must be Exact or Node.\n";
+                std::cerr << "Build Oracle - Error! Type of Oracle must be Exact, noWR or Node.\n";
                 return 1;
             }
 
@@ -237,9 +888,12 @@ int main(int argc, char **argv) {
 
     // -- create FD stream
     if (strcmp(project, "CreateFDStream") == 0) {
-        if (argc != 6) {
+        Options options;
+        bool binary_output;
+        if (argc < 6 or !parse_options(argc, argv, 6, {"format"}, options) or
+            !get_format_option(options, binary_output)) {
             std::cerr << "Usage: CreateFDStream <snapshots_folder> <n_snapshots> <delimiter> <skip>"
-                         " <output_path>\n";
+                         " <output_path> [--format=text|binary]\n";
             return 1;
         } else {
             std::string snapshots_folder(argv[1]);
@@ -248,7 +902,7 @@ int main(int argc, char **argv) {
             int skip = atoi(argv[4]);
             std::string output_path(argv[5]);
             auto start = std::chrono::high_resolution_clock::now();
-            Utils::merge_snapshots_FD(snapshots_folder, n_snapshots, delimiter, skip, output_path);
+            Utils::merge_snapshots_FD(snapshots_folder, n_snapshots, delimiter, skip, output_path, binary_output);
             auto stop = std::chrono::high_resolution_clock::now();
             double time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(stop - start)).count()) / 1000;
             std::cout << "Snapshots folder " << snapshots_folder << " merged in time: " << time << " s\n";
@@ -256,12 +910,77 @@ int main(int argc, char **argv) {
         }
     }
 
+    // -- benchmarks
+    if (strcmp(project, "Benchmark") == 0) {
+        std::string benchmark = argc > 1 ? argv[1] : "";
+        if (benchmark == "rng" and (argc == 2 or argc == 4)) {
+            std::string dataset_path = argc == 4 ? argv[2] : "";
+            long memory_budget = argc == 4 ? atol(argv[3]) : 0;
+            Benchmark::rng(dataset_path, memory_budget);
+            return 0;
+        }
+        if (benchmark == "heap" and argc == 4) {
+            std::string dataset_path = argv[2];
+            long heavy_size = atol(argv[3]);
+            Benchmark::heap(dataset_path, heavy_size);
+            return 0;
+        }
+        if (benchmark == "oracle" and (argc == 4 or argc == 6)) {
+            std::string oracle_path = argv[2];
+            std::string oracle_type = argv[3];
+            std::string dataset_path = argc == 6 ? argv[4] : "";
+            long memory_budget = argc == 6 ? atol(argv[5]) : 0;
+            Benchmark::oracle(oracle_path, oracle_type, dataset_path, memory_budget);
+            return 0;
+        }
+        if (benchmark == "batch" and argc == 7) {
+            bool fully_dynamic = atoi(argv[2]) == 1;
+            std::string dataset_path = argv[3];
+            std::string oracle_path = argv[4];
+            std::string oracle_type = argv[5];
+            long memory_budget = atol(argv[6]);
+            Benchmark::batch(fully_dynamic, dataset_path, oracle_path, oracle_type, memory_budget);
+            return 0;
+        }
+        if (argc >= 4 and strcmp(argv[1], "relabel") == 0) {
+            std::string dataset_path = argv[2];
+            long memory_budget = atol(argv[3]);
+            std::string oracle_path = argc >= 6 ? argv[4] : "";
+            std::string oracle_type = argc >= 6 ? argv[5] : "";
+            std::string scratch_path = dataset_path + ".relabel.bin";
+            Benchmark::relabel(dataset_path, memory_budget, oracle_path, oracle_type, scratch_path);
+            return 0;
+        }
+        std::cerr << "Usage: Benchmark rng [<preprocessed_dataset_path> <memory_budget>]\n"
+                     "       Benchmark heap <preprocessed_fd_dataset_path> <heavy_set_size>\n"
+                     "       Benchmark oracle <oracle_path> <oracle_type = [nodes, edges]>"
+                     " [<preprocessed_dataset_path> <memory_budget>]\n"
+                     "       Benchmark batch <flag: 0: insertion-only stream, 1: fully-dynamic stream>"
+                     " <preprocessed_dataset_path> <oracle_path> <oracle_type = [nodes, edges]> <memory_budget>\n"
+                     "       Benchmark relabel <preprocessed_dataset_path> <memory_budget>"
+                     " [<oracle_path> <oracle_type = [nodes, edges]>]\n";
+        return 1;
+    }
+
     // -- Tonic Algo
     if (strcmp(project, "Tonic") == 0) {
-        if (argc != 10) {
-            std::cerr << "Usage: Tonic <flag: 0: insertion-only stream, 1: fully-dynamic stream>"
-                         " <random_seed> <memory_budget> <alpha> <beta> "
-                         "<dataset_path> <oracle_path> <oracle_type = [nodes, edges]> <output_path>\n";
+        Options options;
+        const char *usage = "Usage: Tonic <flag: 0: insertion-only stream, 1: fully-dynamic stream>"
+                            " <random_seed> <memory_budget> <alpha> <beta> "
+                            "<dataset_path> <oracle_path> <oracle_type = [nodes, edges]> <output_path>"
+                            " [--reader=getline|mmap|pipelined] [--batch-size=<edges>] [--ring-capacity=<batches>]"
+                            " [--hub-degree=<degree, 0 = no hubs>] [--sl-sampling=coin|skip]"
+                            " [--oracle-backend=table|mph] [--oracle-bits=8|16]"
+                            " [--oracle-filter=<bits per key, 0 = no filter>]"
+                            " [--ensemble=<instances>] [--ensemble-groups=<groups>]"
+                            " [--shard-colours=<colours>] [--shard-threads=<n>]"
+                            " [--local-output=<path>] [--local-top=<nodes, 0 = all>] [--num-nodes=<n>]\n";
+        if (argc < 10 or
+            !parse_options(argc, argv, 10, {"reader", "batch-size", "ring-capacity", "hub-degree", "sl-sampling",
+                                            "oracle-backend", "oracle-bits", "oracle-filter", "ensemble",
+                                            "ensemble-groups", "shard-colours", "shard-threads", "local-output",
+                                            "local-top", "num-nodes"}, options)) {
+            std::cerr << usage;
             return 1;
         }
 
@@ -282,62 +1001,238 @@ int main(int argc, char **argv) {
         std::string oracle_path(argv[7]);
         std::string oracle_type(argv[8]);
         std::string output_path(argv[9]);
+        ReaderConfig reader;
+        reader.mode = get_option(options, "reader", "getline");
+        if (!get_number_option(options, "batch-size", reader.batch_size, reader.batch_size) or
+            !get_number_option(options, "ring-capacity", reader.ring_capacity, reader.ring_capacity)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (reader.mode != "getline" and reader.mode != "mmap" and reader.mode != "pipelined") {
+            std::cerr << "Error! Reader must be getline, mmap or pipelined\n";
+            return 1;
+        }
+        if (reader.batch_size == 0 or reader.ring_capacity < 2) {
+            std::cerr << "Error! Batch size must be positive and ring capacity at least 2\n";
+            return 1;
+        }
+        uint32_t hub_degree;
+        if (!get_number_option<uint32_t>(options, "hub-degree", SampledGraph::DEFAULT_HUB_DEGREE, hub_degree)) {
+            std::cerr << usage;
+            return 1;
+        }
+        std::string sl_sampling = get_option(options, "sl-sampling", "coin");
+        if (sl_sampling != "coin" and sl_sampling != "skip") {
+            std::cerr << "Error! SL sampling must be coin or skip\n";
+            return 1;
+        }
+        std::string oracle_backend = get_option(options, "oracle-backend", "table");
+        int oracle_bits;
+        if (!get_number_option(options, "oracle-bits", 16, oracle_bits)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if ((oracle_backend != "table" and oracle_backend != "mph") or (oracle_bits != 8 and oracle_bits != 16)) {
+            std::cerr << "Error! Oracle backend must be table or mph, with 8 or 16 bits\n";
+            return 1;
+        }
+        double oracle_filter;
+        if (!get_number_option(options, "oracle-filter", 0.0, oracle_filter)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (oracle_filter < 0) {
+            std::cerr << "Error! Oracle filter bits per key must be non-negative\n";
+            return 1;
+        }
+        int ensemble, ensemble_groups;
+        if (!get_number_option(options, "ensemble", 1, ensemble) or
+            !get_number_option(options, "ensemble-groups", std::min(ensemble, 5), ensemble_groups)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (ensemble < 1 or ensemble_groups < 1) {
+            std::cerr << "Error! Ensemble instances and groups must be positive\n";
+            return 1;
+        }
+        int shard_colours, shard_threads;
+        if (!get_number_option(options, "shard-colours", 0, shard_colours) or
+            !get_number_option<int>(options, "shard-threads", (int) std::max(1u, std::thread::hardware_concurrency()),
+                                    shard_threads)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (shard_colours < 0 or shard_colours > ColourPartition::MAX_COLOURS or shard_threads < 1) {
+            std::cerr << "Error! Shard colours must be in [0, " << ColourPartition::MAX_COLOURS
+                      << "] and shard threads positive\n";
+            return 1;
+        }
+        if (shard_colours > 0 and (flag_fd == 1 or ensemble > 1)) {
+            std::cerr << "Error! Sharded runs are only for insertion-only streams, without ensembles\n";
+            return 1;
+        }
+        std::string local_output_path = get_option(options, "local-output", "");
+        long local_top;
+        if (!get_number_option(options, "local-top", 0L, local_top)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (local_top < 0) {
+            std::cerr << "Error! Local top must be non-negative\n";
+            return 1;
+        }
+        if (!local_output_path.empty() and (ensemble > 1 or shard_colours > 0)) {
+            std::cerr << "Error! Local counts are only written for single runs, without ensembles or shards\n";
+            return 1;
+        }
+        // -- node ids in [0, num_nodes): given, or read from the header of a relabelled binary stream
+        size_t num_nodes;
+        if (!get_number_option<size_t>(options, "num-nodes", 0, num_nodes)) {
+            std::cerr << usage;
+            return 1;
+        }
+        if (num_nodes == 0) num_nodes = dense_num_nodes(dataset_path);
+        if (reader.mode == "getline" and EdgeStreamReader::is_binary_file(dataset_path)) {
+            std::cout << "Binary stream detected, reading it with the mmap reader\n";
+            reader.mode = "mmap";
+        }
 
         std::chrono::time_point start = std::chrono::high_resolution_clock::now();
         double time, time_oracle;
-        bool edge_oracle_flag = false;
         int size_oracle;
-        emhash5::HashMap<int, int> node_oracle;
-        emhash5::HashMap<long, int> edge_oracle;
-        if (oracle_type == "nodes") {
-            if (!Utils::read_node_oracle(oracle_path, ' ', 0, node_oracle)) return 1;
+        std::shared_ptr<Oracle> oracle;
+        if (Oracle::is_binary_file(oracle_path)) {
+            oracle = Oracle::map_binary_oracle(oracle_path);
+            if (!oracle) return 1;
+            if (oracle_type != (oracle->is_edge_oracle() ? "edges" : "nodes")) {
+                std::cerr << "Error! Binary oracle " << oracle_path << " is not a " << oracle_type << " oracle\n";
+                return 1;
+            }
+            time_oracle = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
+            printf("Binary %s Oracle successfully mapped in time %.3f! Size of the oracle = %zu %s\n",
+                   oracle->is_edge_oracle() ? "Edge" : "Node", time_oracle, oracle->size(), oracle_type.c_str());
+        } else if (oracle_type == "nodes") {
+            oracle = Oracle::read_node_oracle(oracle_path, ' ', 0);
+            if (!oracle) return 1;
             time_oracle = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
-            printf("Node Oracle successfully read in time %.3f! Size of the oracle = %d nodes\n",
-                   time_oracle, node_oracle.size());
-            size_oracle = (int) node_oracle.size();
+            printf("Node Oracle successfully read in time %.3f! Size of the oracle = %zu nodes\n",
+                   time_oracle, oracle->size());
         } else if (oracle_type == "edges") {
-            edge_oracle_flag = true;
-            if (!Utils::read_edge_oracle(oracle_path, ' ', 0, edge_oracle)) return 1;
+            oracle = Oracle::read_edge_oracle(oracle_path, ' ', 0);
+            if (!oracle) return 1;
             time_oracle = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
-            printf("Edge Oracle successfully read in time %.3f! Size of the oracle = %d edges\n",
-                   time_oracle, edge_oracle.size());
-            size_oracle = (int) edge_oracle.size();
+            printf("Edge Oracle successfully read in time %.3f! Size of the oracle = %zu edges\n",
+                   time_oracle, oracle->size());
         } else {
             std::cerr << "Error! Oracle type must be nodes or edges\n";
             return 1;
         }
-        if (flag_fd == 1) {
-            Tonic_FD tonic_FD_algo(random_seed, memory_budget, alpha, beta);
-            if (edge_oracle_flag)
-                tonic_FD_algo.set_edge_oracle(edge_oracle);
-            else
-                tonic_FD_algo.set_node_oracle(node_oracle);
+        if (num_nodes > 0 and oracle_type == "nodes" and oracle_backend == "table") {
+            std::shared_ptr<Oracle> dense = Oracle::build_dense_node_oracle(*oracle, num_nodes);
+            if (dense) {
+                oracle = dense;
+                printf("Dense Node Oracle || %zu node ids, %zu bytes\n", num_nodes, oracle->memory_bytes());
+            } else {
+                std::cout << "Node oracle has ids outside [0, " << num_nodes << "), keeping its table\n";
+            }
+        }
+        if (oracle_filter > 0 and oracle->backend() == Oracle::Backend::DENSE) {
+            // -- a dense lookup is a single array read, misses included, so there is nothing for a filter to save
+            std::cout << "Oracle filter || not used, the dense node oracle answers misses without probing\n";
+        } else if (oracle_filter > 0) {
+            oracle->build_filter(oracle_filter);
+            printf("Oracle filter || %.1f bits/key, %zu bytes\n", oracle_filter, oracle->filter_memory_bytes());
+        }
+        if (oracle_backend == "mph") {
+            oracle = Oracle::build_mph_oracle(*oracle, oracle_bits, oracle_bits);
+            time_oracle = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
+            printf("MPH Oracle successfully built in time %.3f! %d-bit fingerprints and heaviness, %.2f bytes/entry\n",
+                   time_oracle, oracle_bits, (double) oracle->memory_bytes() / (double) std::max<size_t>(1, oracle->size()));
+        }
+        size_oracle = (int) oracle->size();
+        bool edge_oracle_flag = oracle->is_edge_oracle();
+        if (shard_colours > 0) {
+            run_tonic_sharded(shard_colours, shard_threads, random_seed, memory_budget, alpha, beta, oracle, hub_degree,
+                              sl_sampling == "skip", dataset_path, reader.batch_size, output_path, size_oracle,
+                              time_oracle);
+        } else if (ensemble > 1) {
+            // -- instance i is seeded with random_seed + i; the stream is always read with the mmap reader
+            if (flag_fd == 1) {
+                std::vector<std::unique_ptr<Tonic_FD>> instances;
+                for (int i = 0; i < ensemble; i++) {
+                    instances.push_back(std::make_unique<Tonic_FD>(random_seed + i, memory_budget, alpha, beta));
+                    instances.back()->set_oracle(oracle);
+                    instances.back()->set_hub_degree(hub_degree);
+                }
+                run_tonic_ensemble(std::string("TonicFD"), instances, [](Tonic_FD &algo,
+                                                                         std::span<const StreamEdge> batch) {
+                    algo.process_edges(batch);
+                }, ensemble_groups, dataset_path, reader.batch_size, output_path, *oracle, alpha, beta,
+                                   memory_budget, size_oracle, time_oracle);
+            } else {
+                std::vector<std::unique_ptr<Tonic>> instances;
+                for (int i = 0; i < ensemble; i++) {
+                    instances.push_back(std::make_unique<Tonic>(random_seed + i, memory_budget, alpha, beta));
+                    instances.back()->set_oracle(oracle);
+                    instances.back()->set_hub_degree(hub_degree);
+                    instances.back()->set_sl_skip_sampling(sl_sampling == "skip");
+                }
+                run_tonic_ensemble(std::string("TonicINS"), instances, [](Tonic &algo,
+                                                                         std::span<const StreamEdge> batch) {
+                    algo.process_edges(batch);
+                }, ensemble_groups, dataset_path, reader.batch_size, output_path, *oracle, alpha, beta,
+                                   memory_budget, size_oracle, time_oracle);
+            }
+        } else if (flag_fd == 1) {
+            Tonic_FD tonic_FD_algo(random_seed, memory_budget, alpha, beta, !local_output_path.empty());
+            tonic_FD_algo.set_num_nodes(num_nodes);
+            tonic_FD_algo.set_oracle(oracle);
+            tonic_FD_algo.set_hub_degree(hub_degree);
 
             start = std::chrono::high_resolution_clock::now();
-            run_tonic_algo_FD(dataset_path, tonic_FD_algo);
+            run_tonic_algo_FD(dataset_path, tonic_FD_algo, reader);
             time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
 
             write_results(std::string("TonicFD"), tonic_FD_algo.get_global_triangles(), time,
                           output_path, edge_oracle_flag, alpha, beta, memory_budget, size_oracle, time_oracle);
+            print_subgraph_stats(tonic_FD_algo.get_num_nodes(), tonic_FD_algo.get_num_edges(),
+                                 tonic_FD_algo.get_subgraph_memory());
+            print_oracle_stats(*oracle, tonic_FD_algo.get_oracle_stats(), tonic_FD_algo.get_edges_processed(),
+                               dataset_path);
+            if (!local_output_path.empty()) {
+                std::vector<std::pair<int, double>> top_nodes;
+                tonic_FD_algo.get_top_local_triangles((size_t) local_top, top_nodes);
+                write_local_estimates(top_nodes, local_output_path, tonic_FD_algo.get_local_memory());
+            }
 
 
         } else {
-            Tonic tonic_algo(random_seed, memory_budget, alpha, beta);
-            if (edge_oracle_flag)
-                tonic_algo.set_edge_oracle(edge_oracle);
-            else
-                tonic_algo.set_node_oracle(node_oracle);
+            Tonic tonic_algo(random_seed, memory_budget, alpha, beta, !local_output_path.empty());
+            tonic_algo.set_num_nodes(num_nodes);
+            tonic_algo.set_oracle(oracle);
+            tonic_algo.set_hub_degree(hub_degree);
+            tonic_algo.set_sl_skip_sampling(sl_sampling == "skip");
 
             start = std::chrono::high_resolution_clock::now();
-            run_tonic_algo(dataset_path, tonic_algo);
+            run_tonic_algo(dataset_path, tonic_algo, reader);
             time = (double) ((std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::high_resolution_clock::now() - start)).count()) / 1000;
 
             write_results(std::string("TonicINS"), tonic_algo.get_global_triangles(), time,
                           output_path, edge_oracle_flag, alpha, beta, memory_budget, size_oracle, time_oracle);
+            print_subgraph_stats(tonic_algo.get_num_nodes(), tonic_algo.get_num_edges(),
+                                 tonic_algo.get_subgraph_memory());
+            print_oracle_stats(*oracle, tonic_algo.get_oracle_stats(), tonic_algo.get_edges_processed(), dataset_path);
+            if (!local_output_path.empty()) {
+                std::vector<std::pair<int, double>> top_nodes;
+                tonic_algo.get_top_local_triangles((size_t) local_top, top_nodes);
+                write_local_estimates(top_nodes, local_output_path, tonic_algo.get_local_memory());
+            }
 
         }
         std::cout << "Done!\n";